@@ -7,21 +7,85 @@
 // ----  
 
 
-layout (local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+// WORKGROUP_SIZE_X/Y are defined when the shader is compiled. See 'src/workgroup.hpp'
+layout (local_size_x = WORKGROUP_SIZE_X, local_size_y = WORKGROUP_SIZE_Y, local_size_z = 1) in;
 layout (rgba16f, binding = 8) uniform image2D output_img;
 
-uniform vec2 monitor_size;
+// Built-in render parameters, updated once per frame.
+// Layout must match 'struct render_params_t' in 'src/rmsb.hpp'
+layout (std140, binding = 0) uniform RenderParams {
+    vec2  monitor_size;
+    vec2  RENDER_SIZE;  // Can be smaller than the output image.
+    vec2  PIXEL_JITTER; // Subpixel offset for temporal accumulation.
+    float NOISE_SEED;   // Changes every accumulated frame.
+    float ACCUM_BLEND;  // How much of the new color is blended to the image, 1.0 = overwrite.
+    vec3  CameraInputPosition;
+    float RP_FOV;
+    float RP_HIT_DISTANCE;
+    float RP_MAX_RAY_LENGTH;
+    float RP_TRANSLUCENT_STEP_SIZE;
+    float CAMERA_INPUT_YAW;
+    float CAMERA_INPUT_PITCH;
+    float RP_AO_STEP_SIZE;
+    int   RP_AO_NUM_SAMPLES;
+    float RP_AO_FALLOFF;
+    float RP_RELAXATION;
+}; // RenderParams
+
+// Render settings can be baked to constants, they are then defined before this.
+// See 'RMSB::get_baked_defines'
+#ifndef RENDER_PARAMS_BAKED
+#define FOV                   RP_FOV
+#define HIT_DISTANCE          RP_HIT_DISTANCE
+#define MAX_RAY_LENGTH        RP_MAX_RAY_LENGTH
+#define TRANSLUCENT_STEP_SIZE RP_TRANSLUCENT_STEP_SIZE
+#define AO_STEP_SIZE          RP_AO_STEP_SIZE
+#define AO_NUM_SAMPLES        RP_AO_NUM_SAMPLES
+#define AO_FALLOFF            RP_AO_FALLOFF
+#define RELAXATION            RP_RELAXATION
+#endif
+
+// Optional code paths, compiled out when disabled from the settings. See 'src/preproc.hpp'
+#ifndef FEATURE_REFLECTIONS
+#define FEATURE_REFLECTIONS 1
+#endif
+#ifndef FEATURE_TRANSLUCENCY
+#define FEATURE_TRANSLUCENCY 1
+#endif
+#ifndef FEATURE_AO
+#define FEATURE_AO 1
+#endif
+#ifndef FEATURE_SHADOWS
+#define FEATURE_SHADOWS 1
+#endif
+#ifndef FEATURE_TEXTURES
+#define FEATURE_TEXTURES 1
+#endif
+#ifndef FEATURE_DISTANCE_MAP
+#define FEATURE_DISTANCE_MAP 1
+#endif
+#ifndef FEATURE_COMPACT_MATERIAL
+#define FEATURE_COMPACT_MATERIAL 0
+#endif
+
+uniform ivec2 TILE_OFFSET; // Image may be rendered in multiple dispatches.
+
+// Not in RenderParams so it is active only if the shader uses it. See 'RMSB::update_compute_uniform_locations'
 uniform float time;
-uniform float FOV;
-uniform float HIT_DISTANCE;
-uniform float MAX_RAY_LENGTH;
-uniform float TRANSLUCENT_STEP_SIZE;
-uniform float CAMERA_INPUT_YAW;
-uniform float CAMERA_INPUT_PITCH;
-uniform vec3 CameraInputPosition;
-uniform float AO_STEP_SIZE;
-uniform int AO_NUM_SAMPLES;
-uniform float AO_FALLOFF;
+
+// Depth pre-pass. See 'RMSB::dispatch_depth_prepass'
+// WRITE: One ray for each DEPTH_TILE x DEPTH_TILE pixels is cone marched,
+//        the distance all rays of the tile can skip is written to 'depth_img'
+// READ:  First Raymarch() starts from the distance in 'depth_img'
+#define DEPTH_PASS_OFF   0
+#define DEPTH_PASS_WRITE 1
+#define DEPTH_PASS_READ  2
+#define DEPTH_TILE 8
+uniform int DEPTH_PASS;
+
+// entry() still runs after Raymarch() in the pre-pass, the shading functions return right away.
+#define _SKIP_IN_DEPTH_PASS(value) if(DEPTH_PASS == DEPTH_PASS_WRITE) { return value; }
+layout (r32f, binding = 9) uniform image2D depth_img;
 
 uniform sampler2D TEXTURES[16];
 
@@ -37,6 +101,17 @@ uniform sampler2D TEXTURES[16];
     vec3 raycolor_translucent(){ return vec3(0); }
 
 
+// Pixel coordinate of the current invocation.
+#define PIXEL_ID _PixelID()
+
+// In the depth pre-pass this is center of the tile.
+ivec2 _PixelID() {
+    if(DEPTH_PASS == DEPTH_PASS_WRITE) {
+        return ivec2(gl_GlobalInvocationID.xy) * DEPTH_TILE + DEPTH_TILE/2;
+    }
+    return ivec2(gl_GlobalInvocationID.xy) + TILE_OFFSET;
+}
+
 #define Material mat4x3
 #define Mdiffuse(x)     x[0]
 #define Mspecular(x)    x[1]
@@ -46,6 +121,11 @@ uniform sampler2D TEXTURES[16];
 #define Mcanglow(x)     x[3][0]
 #define MtextureID(x)   x[3][1]
 
+// Material with only the values needed for ray marching:
+// Mdistance (x), Mopaque (y), MreflectN (z) and Mcanglow (w)
+// map_dist() is a copy of map() which uses it, see 'Preproc::get_distance_map'
+#define DistMaterial vec4
+
 
 vec3 FOG_COLOR = vec3(0.5, 0.5, 0.5);
 float FOG_DENSITY = 1.0;
@@ -59,6 +139,18 @@ User must define this function.
 FUNC Material map(vec3 p);
 FUNC_END
 
+DistMaterial map_dist(vec3 p);
+
+// Shadows, AO, normals and the ray steps dont need the other material values.
+DistMaterial _MapDist(vec3 p) {
+#if FEATURE_DISTANCE_MAP
+    return map_dist(p);
+#else
+    Material m = map(p);
+    return DistMaterial(Mdistance(m), Mopaque(m), MreflectN(m), Mcanglow(m));
+#endif
+}
+
 
 /* -INFO
 TODO: Add more info
@@ -98,6 +190,12 @@ struct RAY_T
     Material mat; // Material which ray hit.
     Material closest_mat; // Closest material to ray.
 
+    // Surface normal at 'normal_pos', cached by ComputeNormal(Ray.pos)
+    // so the reflection, texture mapping and raycolor() dont compute it again.
+    vec3  normal;
+    vec3  normal_pos;
+    int   has_normal;
+
     float reflect_len; // Ray length after hit to reflective material.
 };
 RAY_T Ray;
@@ -106,6 +204,11 @@ RAY_T Ray;
 
 void entry();
 void main() {
+    ivec2 first_pixel = (DEPTH_PASS == DEPTH_PASS_WRITE)
+        ? ivec2(gl_GlobalInvocationID.xy) * DEPTH_TILE : PIXEL_ID;
+    if(any(greaterThanEqual(first_pixel, ivec2(RENDER_SIZE)))) {
+        return;
+    }
     Ray.volume_color = vec3(0, 0, 0);
     Ray.hit = 0;
     Ray.len = 0;
@@ -114,6 +217,7 @@ void main() {
     Ray.mat = Material(0);
     Ray.closest_mat = Material(0);
     Ray.reflect_len = 0;
+    Ray.has_normal = 0;
     entry();
 }
 
@@ -146,8 +250,9 @@ See https://iquilezles.org/articles/filteringrm/ for better details.
 */
 FUNC vec3 TextureMapping(int texture_id, vec3 ray_pos, vec3 ray_dir, vec3 normal)
 {
-    vec2 res = imageSize(output_img);
-    vec2 id = vec2(gl_GlobalInvocationID.xy);
+    _SKIP_IN_DEPTH_PASS(vec3(0))
+    vec2 res = RENDER_SIZE;
+    vec2 id = vec2(PIXEL_ID) + PIXEL_JITTER;
 
     // Normalized screen-space coordinates.
     vec2 px = (-res.xy + 2.0 * (id.xy + vec2(1.0, 0.0))) / res.y;
@@ -188,6 +293,7 @@ vec3 ApplyFog(vec3 current_color, float raylen)
 */
 FUNC vec3 GetFinalColor()
 {
+    _SKIP_IN_DEPTH_PASS(vec3(0))
     if(Ray.first_hit_dist < 0) {
         Ray.first_hit_dist = Ray.len;
     }
@@ -205,7 +311,13 @@ Set color for the current pixel.
 */
 FUNC void SetPixel(vec3 color)
 {
-    imageStore(output_img, ivec2(gl_GlobalInvocationID.xy), vec4(color, 1.0));
+    if(DEPTH_PASS == DEPTH_PASS_WRITE) {
+        return;
+    }
+    if(ACCUM_BLEND < 1.0) {
+        color = mix(imageLoad(output_img, PIXEL_ID).rgb, color, ACCUM_BLEND);
+    }
+    imageStore(output_img, PIXEL_ID, vec4(color, 1.0));
 }
 FUNC_END
 
@@ -252,8 +364,8 @@ Calculate the initial ray direction.
 */
 FUNC vec3 Raydir()
 {
-    vec2 res = imageSize(output_img);
-    vec2 id = vec2(gl_GlobalInvocationID.xy);
+    vec2 res = RENDER_SIZE;
+    vec2 id = vec2(PIXEL_ID) + PIXEL_JITTER;
 
     float hf = tan((90.0-FOV*0.5)*PI_R);
     return normalize(vec3(id-res*0.5, (res.y*0.5)*hf));
@@ -264,15 +376,32 @@ FUNC_END
 /* -INFO
 This function will return surface normal for given point 'p'
 by sampling the same point buf slightly different offsets.
+   - Normal for Ray.pos is computed only once per hit, it is saved to Ray.normal
 */
 FUNC vec3 ComputeNormal(vec3 p)
 {
-    vec2 e = vec2(0.0005, 0.0);
-    return normalize(vec3(
-        Mdistance(map(p - e.xyy)) - Mdistance(map(p + e.xyy)),
-        Mdistance(map(p - e.yxy)) - Mdistance(map(p + e.yxy)),
-        Mdistance(map(p - e.yyx)) - Mdistance(map(p + e.yyx))
-    ));
+    _SKIP_IN_DEPTH_PASS(vec3(0, 1, 0))
+    if((Ray.has_normal == 1) && (p == Ray.normal_pos)) {
+        return Ray.normal;
+    }
+
+    // Corners of a tetrahedron, 4 samples instead of 6.
+    // https://iquilezles.org/articles/normalsSDF/
+    const float e = 0.0005;
+    const vec2 k = vec2(1.0, -1.0);
+    vec3 normal = -normalize(
+        k.xyy * _MapDist(p + k.xyy * e).x +
+        k.yyx * _MapDist(p + k.yyx * e).x +
+        k.yxy * _MapDist(p + k.yxy * e).x +
+        k.xxx * _MapDist(p + k.xxx * e).x
+    );
+
+    if(p == Ray.pos) {
+        Ray.normal = normal;
+        Ray.normal_pos = p;
+        Ray.has_normal = 1;
+    }
+    return normal;
 }
 FUNC_END
 
@@ -299,8 +428,29 @@ FUNC vec3 Vec3Lerp(float t, vec3 a, vec3 b)
 FUNC_END
 
 int _FLAG_reflect = 0;
+int _FLAG_primary = 1;      // Only the first Raymarch() uses the depth pre-pass.
+float _ray_start_len = 0.0; // Where the next Raymarch_I starts.
 void Raymarch_I(vec3 ro, vec3 rd);
 
+// Distance all rays of the DEPTH_TILE sized tile around 'rd' can skip.
+// The cone covers the tile if the ray directions are from Raydir()
+float _ConeMarchDepth(vec3 ro, vec3 rd) {
+    float focal_len = (RENDER_SIZE.y*0.5) * tan((90.0-FOV*0.5)*PI_R);
+    // Half diagonal of the tile and one pixel for the jitter.
+    float k = (float(DEPTH_TILE)*0.7072 + 1.0) / focal_len;
+    float t = 0.0;
+
+    for(int i = 0; i < 128; i++) {
+        // Nothing is inside the cone radius if this is positive.
+        float d = _MapDist(ro + rd * t).x - k * t;
+        if((d < HIT_DISTANCE) || (t >= MAX_RAY_LENGTH)) {
+            break;
+        }
+        t += d / (1.0 + k);
+    }
+    return min(t, MAX_RAY_LENGTH);
+}
+
 /* -INFO
 Results can be accessed from Ray (RAY_T) struct.
    - ro is the ray origin position.
@@ -316,8 +466,21 @@ FUNC void Raymarch(vec3 ro, vec3 rd)
    // Ray.volume_color = vec3(0);
     Ray.solid_color = vec3(0);
 
+    if(DEPTH_PASS == DEPTH_PASS_WRITE) {
+        if(_FLAG_primary == 1) {
+            imageStore(depth_img, ivec2(gl_GlobalInvocationID.xy), vec4(_ConeMarchDepth(ro, rd)));
+        }
+        _FLAG_primary = 0;
+        return;
+    }
+    if((DEPTH_PASS == DEPTH_PASS_READ) && (_FLAG_primary == 1)) {
+        _ray_start_len = imageLoad(depth_img, PIXEL_ID / DEPTH_TILE).r;
+    }
+    _FLAG_primary = 0;
+
     Raymarch_I(ro, rd);
     
+#if FEATURE_REFLECTIONS
     if(_FLAG_reflect == 1) {
         vec3 normal = ComputeNormal(Ray.pos);
         vec3 new_rd = normalize(reflect(rd, normal));
@@ -338,20 +501,50 @@ FUNC void Raymarch(vec3 ro, vec3 rd)
         Ray.volume_color += Vec3Lerp(R, vec3(0), rayR.volume_color);
    
     }
+#endif
 }
 FUNC_END
 
 // FIXME: reflection ray will go into the material itself
 //        if they are very close to each other.
 
+// With FEATURE_COMPACT_MATERIAL the ray steps keep only DistMaterial,
+// the full Material is computed from map() where the ray hits
+// and for the closest glowing point after the loop.
+#if FEATURE_COMPACT_MATERIAL
+#define _StepMaterial DistMaterial
+#define _StepMap(p)   _MapDist(p)
+#else
+#define _StepMaterial Material
+#define _StepMap(p)   map(p)
+#endif
+
+DistMaterial _StepValues(DistMaterial m) {
+    return m;
+}
+DistMaterial _StepValues(Material m) {
+    return DistMaterial(Mdistance(m), Mopaque(m), MreflectN(m), Mcanglow(m));
+}
+Material _ResolveMaterial(DistMaterial m, vec3 p) {
+    return map(p);
+}
+Material _ResolveMaterial(Material m, vec3 p) {
+    return m;
+}
+
 /* -INFO
 Reflections are not handled by this function.
 Use Raymarch(...) instead.
 */
 FUNC void Raymarch_I(vec3 ro, vec3 rd)
 {    
+    if(DEPTH_PASS == DEPTH_PASS_WRITE) {
+        return;
+    }
     Ray.hit = 0;
-    Ray.len = 0.0;
+    Ray.has_normal = 0;
+    Ray.len = _ray_start_len;
+    _ray_start_len = 0.0;
     Ray.vm_len = 0.0;
     Ray.pos = ro;
     Ray.mat = Material(0);
@@ -360,56 +553,95 @@ FUNC void Raymarch_I(vec3 ro, vec3 rd)
     Ray.first_hit_dist = -1;
     int ray_outside = 1;
 
+    // Over-relaxed sphere tracing, steps are 'omega' times the distance.
+    // It is safe as long as the spheres of the previous and current position overlap,
+    // if they dont the ray may have skipped a surface and it goes back to plain steps.
+    float omega = clamp(RELAXATION, 1.0, 2.0);
+    float prev_dist = 0.0;
+    float step_len = 0.0;
+
+    float glow_dist = Mdistance(Ray.closest_mat);
+    vec3  glow_pos = vec3(0);
+
     while(Ray.len < MAX_RAY_LENGTH) {
         if(ray_outside == 1) {
             Ray.pos = ro + rd * Ray.len;
-            Material c = map(Ray.pos);
-            if((Mcanglow(c) >= 1)
-            && (Mdistance(c) < Mdistance(Ray.closest_mat))) {
+            _StepMaterial c = _StepMap(Ray.pos);
+            DistMaterial v = _StepValues(c);
+            if((omega > 1.0) && (abs(v.x) + prev_dist < step_len)) {
+                Ray.len += prev_dist - step_len;
+                step_len = prev_dist;
+                omega = 1.0;
+                continue;
+            }
+            if((v.w >= 1) && (v.x < glow_dist)) {
+                glow_dist = v.x;
+#if FEATURE_COMPACT_MATERIAL
+                glow_pos = Ray.pos;
+#else
                 Ray.closest_mat = c;
+#endif
             }
-            if(Mdistance(c) <= HIT_DISTANCE) {
+            if(v.x <= HIT_DISTANCE) {
                 Ray.hit = 1;
-                Ray.mat = c;
+                Ray.mat = _ResolveMaterial(c, Ray.pos);
 
                 if(Ray.first_hit_dist < 0) {
                     Ray.first_hit_dist = Ray.len;
                 }
 
-                if(MreflectN(c) > 0.0) {
+#if FEATURE_REFLECTIONS
+                if(v.z > 0.0) {
                     _FLAG_reflect = 1;
                     break;
                 }
-                else
-                if(Mopaque(c) < 1.0) {
-                    Ray.mat = c;
+#endif
+#if FEATURE_TRANSLUCENCY
+                if(v.y < 1.0) {
                     ray_outside = 0;
                 }
                 else {
                     break;
                 }
+#else
+                break;
+#endif
             }
 
-            Ray.len += Mdistance(c);
+            prev_dist = v.x;
+            step_len = prev_dist * omega;
+            Ray.len += step_len;
         }
+#if FEATURE_TRANSLUCENCY
         else {
             Ray.pos = ro + rd * (Ray.len + Ray.vm_len);
 
-            Material c = map(Ray.pos);
-            if(Mdistance(c) >= HIT_DISTANCE+0.01) {
+            _StepMaterial c = _StepMap(Ray.pos);
+            if(_StepValues(c).x >= HIT_DISTANCE+0.01) {
                 Ray.volume_color += raycolor_translucent();
                 Ray.volume_color = clamp(Ray.volume_color, vec3(0), vec3(1));
-                Ray.mat = c;
+                Ray.mat = _ResolveMaterial(c, Ray.pos);
                 Ray.len += Ray.vm_len;
                 ray_outside = 1;
+                prev_dist = 0.0;
+                step_len = 0.0;
             }
             Ray.vm_len += TRANSLUCENT_STEP_SIZE;
         }       
+#endif
+    }
+
+#if FEATURE_COMPACT_MATERIAL
+    if(glow_dist < Mdistance(Ray.closest_mat)) {
+        Ray.closest_mat = map(glow_pos);
     }
+#endif
 
+#if FEATURE_TEXTURES
     if(MtextureID(Ray.mat) > 0) {
         Mdiffuse(Ray.mat) = TextureMapping(int(round(MtextureID(Ray.mat)))-1, Ray.pos, rd, ComputeNormal(Ray.pos));
     }
+#endif
 
     Ray.solid_color += ApplyFog(raycolor(), Ray.len);
     //Ray.solid_color = ApplyFog(Ray.solid_color, Ray.len);
@@ -429,6 +661,10 @@ https://iquilezles.org/articles/rmshadows/
 */
 FUNC float GetShadowExt(vec3 p, vec3 light_dir, float w, float max_value)
 {
+    _SKIP_IN_DEPTH_PASS(1.0)
+#if !FEATURE_SHADOWS
+    return 1.0;
+#else
     w = MapValue(w, 0.0, 1.0, 0.001, 0.1);
     float shadow = 1.0;
     RAY_T old_ray = Ray;
@@ -447,17 +683,17 @@ FUNC float GetShadowExt(vec3 p, vec3 light_dir, float w, float max_value)
 
     while(Ray.len < (MAX_RAY_LENGTH/2)) {
         Ray.pos = p + light_dir * Ray.len;
-        Material c = map(Ray.pos);
-        float dist = Mdistance(c);
+        DistMaterial c = _MapDist(Ray.pos);
+        float dist = c.x;
 
-        if(Mopaque(c) > 0.001) {
+        if(c.y > 0.001) {
             if(dist <= 0.0001) {
                 shadow = 0.0;
-                hit_opaque = Mopaque(c);
+                hit_opaque = c.y;
                 break;
             }
 
-            float h = Mdistance(c);
+            float h = c.x;
             float y = h * h / (2.0 * ph);
             float d = sqrt(h*h - y*y);
             shadow = min(shadow, d/(w*max(0.0, Ray.len-y)));
@@ -475,6 +711,7 @@ FUNC float GetShadowExt(vec3 p, vec3 light_dir, float w, float max_value)
 
 
     return clamp(shadow, max_value, 1.0);
+#endif
 }
 FUNC_END
 
@@ -507,6 +744,10 @@ Returns ambient occlusion value for point p (current ray position)
 */
 FUNC float AmbientOcclusion(vec3 p, vec3 normal)
 {
+    _SKIP_IN_DEPTH_PASS(1.0)
+#if !FEATURE_AO
+    return 1.0;
+#else
     RAY_T old_ray = Ray; // Save ray if user modifies it from map function.
     float ao = 0.0;
 
@@ -514,7 +755,8 @@ FUNC float AmbientOcclusion(vec3 p, vec3 normal)
 
         // Get random vector and normalize it to -1.0 to 1.0.
         // Time is added to reduce noise visible to human eye.
-        vec3 rV = Hash3(p + i + time*2) * 2.0 - 1.0;
+        // Noise seed changes every frame when accumulating.
+        vec3 rV = Hash3(p + i + time*2 + NOISE_SEED) * 2.0 - 1.0;
 
         // Decrease rV contribution to direction
         // as the distance increases.
@@ -522,7 +764,7 @@ FUNC float AmbientOcclusion(vec3 p, vec3 normal)
         t = pow(t, AO_FALLOFF);
 
         vec3 dir = (-normal) * (i * AO_STEP_SIZE) + (rV * t);
-        float dist = Mdistance(map(dir + p));
+        float dist = _MapDist(dir + p).x;
 
         ao += max(dist, 0.0);
     }
@@ -531,6 +773,7 @@ FUNC float AmbientOcclusion(vec3 p, vec3 normal)
 
     Ray = old_ray;
     return ao;
+#endif
 }
 FUNC_END
 
@@ -582,6 +825,26 @@ FUNC Material SmoothMixMaterial(Material a, Material b, float k)
 }
 FUNC_END
 
+// Same as above for DistMaterial, only map_dist() uses these.
+DistMaterial _DistEmptyMaterial() {
+    return DistMaterial(MAX_RAY_LENGTH+1.0, 1.0, 0.0, 0.0);
+}
+DistMaterial MaterialMin(DistMaterial a, DistMaterial b) {
+    return (a.x < b.x) ? a : b;
+}
+DistMaterial MaterialMax(DistMaterial a, DistMaterial b) {
+    return (a.x > b.x) ? a : b;
+}
+DistMaterial MixMaterial(DistMaterial a, DistMaterial b, float t) {
+    return DistMaterial(mix(a.x, b.x, t), 1.0, 0.0, 0.0);
+}
+DistMaterial SmoothMixMaterial(DistMaterial a, DistMaterial b, float k) {
+    float t = clamp(0.5+0.5 * (b.x - a.x) / k, 0.0, 1.0);
+    DistMaterial m = MixMaterial(b, a, t);
+    m.x -= k * t * (1.0 - t);
+    return m;
+}
+
 
 /* -INFO
 Calculate light values for the material 'm'
@@ -590,6 +853,7 @@ Calculate light values for the material 'm'
 */
 FUNC vec3 LightDirectional(vec3 eye, vec3 direction, vec3 color, vec3 normal, Material m)
 {
+    _SKIP_IN_DEPTH_PASS(vec3(0))
     vec3 view_dir = normalize(eye - Ray.pos);
     vec3 light_dir = -normalize(direction);
     vec3 halfway_dir = normalize(light_dir - view_dir);
@@ -614,6 +878,7 @@ Calculate light values for the material 'm'
 */
 FUNC vec3 LightPoint(vec3 eye, vec3 pos, vec3 color, float radius, float att, vec3 normal, Material m)
 {
+    _SKIP_IN_DEPTH_PASS(vec3(0))
 
     vec3 light_dir = normalize(Ray.pos - pos);
     vec3 view_dir = normalize(eye - Ray.pos);
@@ -22,17 +22,16 @@ void Config::read_values_before_init(const INIReader& ini, Settings* settings) {
 }
 
 
-void Config::read_values_after_init(const INIReader& ini, RMSB* rmsb) {
-
-    // Note:
-    // The errors happening with config file reading
-    // should be displayed to the user with rmsb->loginfo 
-    // and written to logfile.
+void Config::read_render_settings(const INIReader& ini, RMSB* rmsb) {
 
     rmsb->fps_limit = ini.GetInteger(
             "render_settings",
             "fps_limit", 125);
 
+    rmsb->scene_fps = ini.GetInteger(
+            "render_settings",
+            "scene_fps", 0);
+
     rmsb->fov = ini.GetReal(
             "render_settings",
             "fov", 60.0);  
@@ -45,6 +44,10 @@ void Config::read_values_after_init(const INIReader& ini, RMSB* rmsb) {
             "render_settings",
             "max_ray_length", 500.0);
     
+    rmsb->relaxation = ini.GetReal(
+            "render_settings",
+            "relaxation", 1.0);
+    
     rmsb->ao_step_size = ini.GetReal(
             "render_settings",
         "ao_step", 0.01);
@@ -60,7 +63,61 @@ void Config::read_values_after_init(const INIReader& ini, RMSB* rmsb) {
     rmsb->translucent_step_size = ini.GetReal(
             "render_settings",
             "translucent_step", 0.1);
+    
+    rmsb->tiled_rendering = ini.GetBoolean(
+            "render_settings",
+            "tiled_rendering", false);
+    
+    rmsb->tile_budget_ms = ini.GetReal(
+            "render_settings",
+            "tile_budget_ms", 8.0);
+    
+    rmsb->temporal_accumulation = ini.GetBoolean(
+            "render_settings",
+            "temporal_accumulation", true);
+    
+    rmsb->accum_max_frames = ini.GetInteger(
+            "render_settings",
+            "accum_max_frames", 64);
+    
+    rmsb->depth_prepass = ini.GetBoolean(
+            "render_settings",
+            "depth_prepass", false);
+    
+    rmsb->bake_uniforms = ini.GetBoolean(
+            "render_settings",
+            "bake_uniforms", false);
 
+    for(int i = 0; i < FEATURE_COUNT; i++) {
+        rmsb->features[i] = ini.GetBoolean(
+                "render_settings",
+                SHADER_FEATURES[i].ini_key, SHADER_FEATURES[i].default_enabled);
+    }
+}
+
+
+bool Config::reload_render_settings(RMSB* rmsb) {
+    INIReader ini(CONFIG_FILE);
+    if(ini.ParseError() < 0) {
+        rmsb->loginfo(RED, "Failed to read '%s'", CONFIG_FILE);
+        append_logfile(ERROR, "Failed to read '%s'", CONFIG_FILE);
+        return false;
+    }
+
+    read_render_settings(ini, rmsb);
+    SetTargetFPS(rmsb->fps_limit);
+    return true;
+}
+
+
+void Config::read_values_after_init(const INIReader& ini, RMSB* rmsb) {
+
+    // Note:
+    // The errors happening with config file reading
+    // should be displayed to the user with rmsb->loginfo 
+    // and written to logfile.
+
+    read_render_settings(ini, rmsb);
 
     std::string res_str = ini.GetString(
             "render_settings",
@@ -74,6 +131,19 @@ void Config::read_values_after_init(const INIReader& ini, RMSB* rmsb) {
     int res_x = rmsb->monitor_width;
     int res_y = rmsb->monitor_height;
 
+    if(res_str == "DYNAMIC") {
+        rmsb->dynamic_resolution = true;
+        rmsb->dynamic_target_ms = ini.GetReal(
+                "render_settings",
+                "dynamic_target_ms", 8.0);
+
+        if(rmsb->dynamic_target_ms <= 0.0f) {
+            rmsb->loginfo(RED, "Dynamic resolution target time is invalid, set to 8ms.");
+            append_logfile(ERROR, "Dynamic resolution target time is invalid. Too small.");
+            rmsb->dynamic_target_ms = 8.0f;
+        }
+    }
+    else
     if(res_str == "HALF") {
         res_x /= 2;
         res_y /= 2;
@@ -115,6 +185,12 @@ void Config::read_values_after_init(const INIReader& ini, RMSB* rmsb) {
 
     rmsb->render_texture = rmsb->create_empty_texture(
             res_x, res_y, GL_RGBA16F);
+
+    rmsb->render_width = res_x;
+    rmsb->render_height = res_y;
+    if(rmsb->dynamic_resolution) {
+        rmsb->set_dynamic_resolution(true);
+    }
     
     SetTargetFPS(rmsb->fps_limit);
 }
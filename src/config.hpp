@@ -4,6 +4,9 @@
 #include "libs/INIReader.h"
 
 
+static constexpr const char*
+    CONFIG_FILE = "rmsb.ini";
+
 
 namespace Config 
 {
@@ -20,6 +23,14 @@ namespace Config
     void read_values_before_init(const INIReader& ini, Settings* settings);
     void read_values_after_init(const INIReader& ini, RMSB* rmsb);
 
+    // Only the raymarching values (fov, hit distance, ...)
+    // This doesnt need a window to exist.
+    void read_render_settings(const INIReader& ini, RMSB* rmsb);
+
+    // Reads the render settings again from CONFIG_FILE after it was changed.
+    // Render resolution and fonts are not changed.
+    bool reload_render_settings(RMSB* rmsb);
+
 };
 
 
@@ -56,10 +56,10 @@ void Editor::init(const char* font_filepath) {
     this->opacity = 245;
     this->key_repeat_delay = 0.250;
     this->key_repeat_speed = 0.050;
-    this->diff_check_delay = 1.0;
     
     this->error_row = 0;
     this->error_column = 0;
+    m_saved_hash = 0;
 
     this->clipboard.clear();
     m_fontsize = 16;
@@ -105,6 +105,7 @@ void Editor::clear() {
 
 void Editor::undo() {
     m_undo_stack.pop_snapshot(&m_data, &cursor);
+    this->content_changed = true;
 }
 
 void Editor::update_undo_stack() {
@@ -127,6 +128,7 @@ void Editor::add_data(int64_t x, int64_t y, const std::string& data) {
     std::string* ln = get_line(y);
     x = iclamp64(x, 0, ln->size());
     ln->insert(x, data);
+    this->content_changed = true;
 }
 
 void Editor::rem_data(int64_t x, int64_t y, size_t size) {
@@ -147,6 +149,7 @@ void Editor::rem_data(int64_t x, int64_t y, size_t size) {
     }
 
     ln->erase(x, size);
+    this->content_changed = true;
 }
 
 void Editor::load_data(const std::string& data) {
@@ -162,6 +165,7 @@ void Editor::load_data(const std::string& data) {
         line += data[i];
     }
 
+    m_saved_hash = std::hash<std::string>{}(data);
     reset_diff();
 }
         
@@ -181,16 +185,16 @@ void Editor::save(const std::string& filepath) {
     UniformMetadata::write(&shader_code);
 
     SaveFileText(filepath.c_str(), (char*)shader_code.c_str());
+    m_saved_hash = std::hash<std::string>{}(shader_code);
     reset_diff();
 }
 
-void Editor::update_diff() {
-    this->content_changed = (m_content_hash != std::hash<std::string>{}(get_content()));
-}
-
 void Editor::reset_diff() {
     this->content_changed = false;
-    m_content_hash = std::hash<std::string>{}(get_content());
+}
+
+bool Editor::is_saved_content(const std::string& file_content) {
+    return (m_saved_hash == std::hash<std::string>{}(file_content));
 }
 
 std::string Editor::get_content() {
@@ -535,7 +539,7 @@ void Editor::resize_editor_with_mouse() {
     }
 }
 
-void Editor::update(RMSB* rmsb) {
+void Editor::update() {
     if(!this->open) {
         return;
     }
@@ -626,26 +630,6 @@ void Editor::update(RMSB* rmsb) {
     m_prev_cursor = cursor;
 
 
-
-    const float frame_dt = GetFrameTime();
-    m_idle_timer += frame_dt;
-   
-    // Auto reload.
-    if(rmsb->auto_reload
-    && (m_idle_timer >= rmsb->auto_reload_delay)) {
-        m_idle_timer = 0;
-        if(content_changed) {
-            rmsb->reload_shader();
-            reset_diff();
-        }
-    }
-
-    // Content difference check.
-    m_diff_check_timer += frame_dt;
-    if(m_diff_check_timer >= this->diff_check_delay) {
-        m_diff_check_timer = 0;
-        update_diff();
-    }
 }
 
 void Editor::unselect() {
@@ -760,6 +744,7 @@ void Editor::paste_clipboard() {
         // Now add the right substring back.
         m_data.insert(m_data.begin() + cursor.y+iy+1, rsubstr);
     }
+    this->content_changed = true;
 }
 
 
@@ -780,6 +765,7 @@ std::string* Editor::get_line(int64_t y) {
 void Editor::add_char(char c, int64_t x, int64_t y) {
     std::string* line = get_line(y);
     const size_t line_size = line->size();
+    this->content_changed = true;
     if(x < 0) {
         x = 0;
     }
@@ -800,6 +786,7 @@ void Editor::add_tabs(int64_t x, int64_t y, int count) {
             line->insert(x, " ");
         }
     }
+    this->content_changed = true;
 }
 
 char Editor::rem_char(int64_t x, int64_t y) {
@@ -813,6 +800,7 @@ char Editor::rem_char(int64_t x, int64_t y) {
     }
 
     char rmchr = (*line)[x-1];
+    this->content_changed = true;
 
     if(x >= (int64_t)line_size) {
         line->pop_back();
@@ -897,7 +885,7 @@ void Editor::remove_selected() {
     }
         
     m_select.active = false;
-    
+    this->content_changed = true;
 }
         
 bool Editor::is_tab_being_removed(const Cursor& cur) {
@@ -953,6 +941,7 @@ void Editor::handle_backspace() {
         *up += *current;
 
         m_data.erase(m_data.begin()+cursor.y);
+        this->content_changed = true;
         move_cursor(0, -1);
         move_cursor(up->size() - current_size, 0);
     }
@@ -966,6 +955,7 @@ void Editor::handle_enter() {
     std::string* current = get_line(cursor.y);
     size_t current_size = current->size();
     m_data.insert(m_data.begin()+cursor.y+1, ""); // Add new line.
+    this->content_changed = true;
 
     if(cursor.x < (int64_t)current_size) {
         /* Line was split */
@@ -1169,6 +1159,7 @@ void Editor::swap_line(int64_t y, int offset) {
 
     *to = *current;
     *current = m_tmp_str;
+    this->content_changed = true;
 }
 
 void Editor::handle_key_input(int bypassed_check) {  
@@ -1221,8 +1212,6 @@ void Editor::handle_key_input(int bypassed_check) {
         add_tabs(cursor.x, cursor.y, 1);
         move_cursor(TAB_WIDTH, 0);
     }
-
-    m_idle_timer = 0;
 }
 
 
@@ -44,7 +44,7 @@ class Editor {
         void quit();
 
         void render(RMSB* rmsb);
-        void update(RMSB* rmsb);
+        void update();
 
         bool open;
         char char_input;
@@ -76,13 +76,13 @@ class Editor {
         float key_repeat_delay;
         float key_repeat_speed;
         int   opacity;
-        
-        // Difference check timer.
-        // When 'm_diff_check_timer' reaches this variable's value.
-        // The editor will compare its contents hash to previous one.
-        float diff_check_delay;
+
+        // 'content_changed' is set when the content is edited.
         void reset_diff();
-        void update_diff();
+
+        // True if 'file_content' is what the editor last saved or loaded.
+        // Used to know if the shader file was changed by someone else.
+        bool is_saved_content(const std::string& file_content);
         
         Font font; 
         float undo_save_time;
@@ -99,9 +99,6 @@ class Editor {
         void        update_undo_stack();
         float       m_resize_area_size;
 
-        double m_diff_check_timer;
-        double m_idle_timer;
-
         struct selectreg_t {
             uint64_t start_x;
             uint64_t start_y;
@@ -147,7 +144,7 @@ class Editor {
         void handle_select_with_mouse();
         void handle_select_with_keys();
 
-        uint64_t m_content_hash;
+        uint64_t m_saved_hash;
 
         void get_selected(struct selectreg_t* reg);
         void start_selection();
@@ -5,12 +5,47 @@
 #include "error_log.hpp"
 #include "rmsb_gui.hpp"
 #include "internal_lib.hpp"
+#include "shader_util.hpp"
+#include "preproc.hpp"
 
 
 
 void ErrorLog::add(const char* text) {
-    m_log.push_back(text);
+    std::string log = text;
+
+    // Included files are shown with their path instead of the source string number.
+    size_t line_begin = 0;
+    while(line_begin < log.size()) {
+        size_t num_end = line_begin;
+        while((num_end < log.size()) && isdigit((unsigned char)log[num_end])) {
+            num_end++;
+        }
+        size_t line_end = log.find('\n', line_begin);
+
+        if((num_end > line_begin) && (num_end < log.size())
+        && ((log[num_end] == ':') || (log[num_end] == '('))) {
+            const int source = atoi(log.c_str() + line_begin);
+            if(source == SHADER_SOURCE_DISTANCE_MAP) {
+                // Same error is in map(), the copy is not shown.
+                log.erase(line_begin, (line_end == std::string::npos) ? std::string::npos : (line_end + 1 - line_begin));
+                continue;
+            }
+            const char* name = Preproc::get_source_name(source);
+            if(name) {
+                log.replace(line_begin, num_end - line_begin, name);
+                line_end = log.find('\n', line_begin);
+            }
+        }
+
+        if(line_end == std::string::npos) {
+            break;
+        }
+        line_begin = line_end + 1;
+    }
 
+    if(!log.empty()) {
+        m_log.push_back(log);
+    }
 }
 
 void ErrorLog::clear() {
@@ -35,6 +70,12 @@ void ErrorLog::render() {
     ImGui::End();
 }
 
+void ErrorLog::print() {
+    for(const std::string& line : m_log) {
+        fprintf(stderr, "%s\n", line.c_str());
+    }
+}
+
 
 void ErrorLog::get_error_position(int64_t* row, int64_t* col) {
     if(m_log.empty()) { 
@@ -42,14 +83,37 @@ void ErrorLog::get_error_position(int64_t* row, int64_t* col) {
     }
 
     /*
-       ,- Row.
-       v
-    0:512(1): <the error message>
-          ^
-          `- Column.
+       ,- Source string.
+       | ,- Row.
+       v v
+       0:512(1): <the error message>
+             ^
+             `- Column.
     */
-   
-    const std::string& firstln = m_log.front();
+
+    // Only errors in the user code have a position in the editor.
+    // Library code has different source string number. See 'src/shader_util.hpp'
+    const std::string& log = m_log.front();
+    std::string firstln = "";
+
+    size_t line_begin = 0;
+    while(line_begin < log.size()) {
+        size_t line_end = log.find('\n', line_begin);
+        if(line_end == std::string::npos) {
+            line_end = log.size();
+        }
+        std::string line = log.substr(line_begin, line_end - line_begin);
+        if(!line.empty() && isdigit((unsigned char)line[0])
+        && (atol(line.c_str()) == SHADER_SOURCE_USER)) {
+            firstln = line;
+            break;
+        }
+        line_begin = line_end + 1;
+    }
+
+    if(firstln.empty()) {
+        return;
+    }
     
     size_t colon_pos = firstln.find(':');
     if(colon_pos == std::string::npos) {
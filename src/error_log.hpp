@@ -23,6 +23,7 @@ class ErrorLog {
         void clear();
         bool empty();
         void render();
+        void print(); // Print to stderr, used when there is no gui.
 
         // Avoid accidental copies.
         ErrorLog(ErrorLog const&) = delete;
@@ -0,0 +1,136 @@
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+
+#include "file_watcher.hpp"
+#include "logfile.hpp"
+
+
+bool FileWatcher::init() {
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(m_fd < 0) {
+        append_logfile(ERROR, "Failed to initialize inotify: %s", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+void FileWatcher::quit() {
+    if(m_fd < 0) {
+        return;
+    }
+
+    // Closing the descriptor removes all watches.
+    close(m_fd);
+    m_fd = -1;
+    m_dirs.clear();
+    m_files.clear();
+}
+
+void FileWatcher::watch(const std::string& filepath, WatchTarget target) {
+    if(m_fd < 0) {
+        return;
+    }
+
+    std::error_code ec;
+    const std::filesystem::path path = std::filesystem::absolute(filepath, ec).lexically_normal();
+    if(ec) {
+        return;
+    }
+
+    const std::string dir = path.parent_path().string();
+    const std::string name = path.filename().string();
+
+    // inotify returns the same descriptor if the directory is already watched.
+    const int wd = inotify_add_watch(m_fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if(wd < 0) {
+        append_logfile(ERROR, "Failed to watch \"%s\": %s", dir.c_str(), strerror(errno));
+        return;
+    }
+
+    bool dir_found = false;
+    for(const struct watched_dir_t& d : m_dirs) {
+        if(d.wd == wd) {
+            dir_found = true;
+            break;
+        }
+    }
+    if(!dir_found) {
+        m_dirs.push_back((struct watched_dir_t) { wd, dir });
+    }
+
+    for(const struct watched_file_t& f : m_files) {
+        if((f.wd == wd) && (f.name == name) && (f.target == target)) {
+            return;
+        }
+    }
+    m_files.push_back((struct watched_file_t) { wd, name, target });
+}
+
+void FileWatcher::unwatch_all(WatchTarget target) {
+    for(size_t i = 0; i < m_files.size();) {
+        if(m_files[i].target == target) {
+            m_files.erase(m_files.begin() + i);
+            continue;
+        }
+        i++;
+    }
+
+    // Directories which have no files left are not needed anymore.
+    for(size_t i = 0; i < m_dirs.size();) {
+        bool used = false;
+        for(const struct watched_file_t& f : m_files) {
+            if(f.wd == m_dirs[i].wd) {
+                used = true;
+                break;
+            }
+        }
+        if(!used) {
+            inotify_rm_watch(m_fd, m_dirs[i].wd);
+            m_dirs.erase(m_dirs.begin() + i);
+            continue;
+        }
+        i++;
+    }
+}
+
+uint32_t FileWatcher::poll() {
+    if(m_fd < 0) {
+        return 0;
+    }
+
+    uint32_t changed = 0;
+    alignas(struct inotify_event) char buffer[4096];
+
+    while(true) {
+        const ssize_t size = read(m_fd, buffer, sizeof(buffer));
+        if(size <= 0) {
+            break; // EAGAIN when there are no more events.
+        }
+
+        for(ssize_t i = 0; i < size;) {
+            const struct inotify_event* event = (const struct inotify_event*)&buffer[i];
+            i += sizeof(struct inotify_event) + event->len;
+
+            if(event->mask & IN_Q_OVERFLOW) {
+                // Events were lost, anything may have changed.
+                changed = WATCH_BIT(WATCH_TARGET_COUNT) - 1;
+                continue;
+            }
+            if(event->len == 0) {
+                continue;
+            }
+
+            for(const struct watched_file_t& f : m_files) {
+                if((f.wd == event->wd) && (f.name == event->name)) {
+                    changed |= WATCH_BIT(f.target);
+                }
+            }
+        }
+    }
+
+    return changed;
+}
+
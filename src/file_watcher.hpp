@@ -0,0 +1,61 @@
+#ifndef FILE_WATCHER_HPP
+#define FILE_WATCHER_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+// Tells when files are changed on disk. (Linux inotify)
+// The parent directories are watched instead of the files
+// because many editors save by writing a new file and renaming it over the old one.
+
+enum WatchTarget : int {
+    WATCH_SHADER = 0,  // Shader open in the editor.
+    WATCH_LIBRARY,     // 'internal.glsl'
+    WATCH_CONFIG,      // 'rmsb.ini'
+    WATCH_INCLUDE,     // Files included by the shader.
+
+    WATCH_TARGET_COUNT
+};
+
+#define WATCH_BIT(target) (1u << (target))
+
+
+class FileWatcher {
+    public:
+        FileWatcher() : m_fd(-1) {}
+
+        bool init();
+        void quit();
+
+        bool is_active() { return (m_fd >= 0); }
+
+        void watch(const std::string& filepath, WatchTarget target);
+        void unwatch_all(WatchTarget target);
+
+        // Returns WATCH_BIT of each target which had files changed since the previous call.
+        // Doesnt block, can be called every frame.
+        uint32_t poll();
+
+    private:
+
+        struct watched_dir_t {
+            int wd;
+            std::string path;
+        };
+
+        struct watched_file_t {
+            int wd;
+            std::string name;
+            WatchTarget target;
+        };
+
+        int m_fd;
+        std::vector<struct watched_dir_t>  m_dirs;
+        std::vector<struct watched_file_t> m_files;
+};
+
+
+
+#endif
@@ -0,0 +1,223 @@
+#include "libs/glad.h"
+#include <raylib.h>
+#include <rlgl.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+
+#include "gpu_timer.hpp"
+#include "logfile.hpp"
+
+
+void GpuTimer::init() {
+    glGenQueries(GPU_TIMER_LATENCY * GPU_PHASE_COUNT * 2, &m_queries[0][0][0]);
+
+    memset(m_issued, 0, sizeof(m_issued));
+    memset(m_slot_frame, 0, sizeof(m_slot_frame));
+    memset(m_history, 0, sizeof(m_history));
+    memset(m_history_size, 0, sizeof(m_history_size));
+    memset(m_history_index, 0, sizeof(m_history_index));
+    memset(m_num_samples, 0, sizeof(m_num_samples));
+
+    m_frame = 0;
+    m_slot = 0;
+    m_csv = NULL;
+    m_initialized = true;
+    this->enabled = false;
+}
+
+void GpuTimer::quit() {
+    if(!m_initialized) {
+        return;
+    }
+
+    this->stop_csv();
+    glDeleteQueries(GPU_TIMER_LATENCY * GPU_PHASE_COUNT * 2, &m_queries[0][0][0]);
+    m_initialized = false;
+}
+
+void GpuTimer::add_sample(GpuTimerPhase phase, float ms) {
+    m_history[phase][m_history_index[phase]] = ms;
+    m_history_index[phase] = (m_history_index[phase] + 1) % GPU_TIMER_HISTORY_SIZE;
+    m_num_samples[phase]++;
+    if(m_history_size[phase] < GPU_TIMER_HISTORY_SIZE) {
+        m_history_size[phase]++;
+    }
+}
+
+void GpuTimer::read_slot(uint32_t slot, bool wait) {
+    float ms[GPU_PHASE_COUNT] = { 0 };
+    bool  has_result[GPU_PHASE_COUNT] = { 0 };
+    bool  any_result = false;
+
+    for(int phase = 0; phase < GPU_PHASE_COUNT; phase++) {
+        if(!m_issued[slot][phase]) {
+            continue;
+        }
+
+        if(!wait) {
+            // End timestamp is always written after the begin timestamp
+            // so if it is available the begin is too.
+            GLint available = 0;
+            glGetQueryObjectiv(m_queries[slot][phase][1], GL_QUERY_RESULT_AVAILABLE, &available);
+            if(!available) {
+                continue;
+            }
+        }
+
+        GLuint64 begin_ns = 0;
+        GLuint64 end_ns = 0;
+        glGetQueryObjectui64v(m_queries[slot][phase][0], GL_QUERY_RESULT, &begin_ns);
+        glGetQueryObjectui64v(m_queries[slot][phase][1], GL_QUERY_RESULT, &end_ns);
+
+        m_issued[slot][phase] = false;
+        if(end_ns < begin_ns) {
+            continue;
+        }
+
+        ms[phase] = (float)((double)(end_ns - begin_ns) / 1000000.0);
+        has_result[phase] = true;
+        any_result = true;
+        add_sample((GpuTimerPhase)phase, ms[phase]);
+    }
+
+    if(m_csv && any_result) {
+        fprintf(m_csv, "%" PRIu64, m_slot_frame[slot]);
+        for(int phase = 0; phase < GPU_PHASE_COUNT; phase++) {
+            if(has_result[phase]) {
+                fprintf(m_csv, ",%0.4f", ms[phase]);
+            }
+            else {
+                fprintf(m_csv, ",");
+            }
+        }
+        fprintf(m_csv, "\n");
+    }
+}
+
+void GpuTimer::begin_frame() {
+    if(!m_initialized) {
+        return;
+    }
+
+    m_frame++;
+    m_slot = m_frame % GPU_TIMER_LATENCY;
+
+    // The queries in this slot were issued GPU_TIMER_LATENCY frames ago.
+    // If the results are still not available they are dropped, the queries get reused.
+    read_slot(m_slot, false);
+    memset(m_issued[m_slot], 0, sizeof(m_issued[m_slot]));
+    m_slot_frame[m_slot] = m_frame;
+}
+
+void GpuTimer::begin(GpuTimerPhase phase) {
+    if(!m_initialized || !this->enabled) {
+        return;
+    }
+
+    rlDrawRenderBatchActive();
+    glQueryCounter(m_queries[m_slot][phase][0], GL_TIMESTAMP);
+}
+
+void GpuTimer::end(GpuTimerPhase phase) {
+    if(!m_initialized || !this->enabled) {
+        return;
+    }
+
+    rlDrawRenderBatchActive();
+    glQueryCounter(m_queries[m_slot][phase][1], GL_TIMESTAMP);
+    m_issued[m_slot][phase] = true;
+}
+
+void GpuTimer::wait_results() {
+    if(!m_initialized) {
+        return;
+    }
+
+    // Oldest first so the csv rows stay in order.
+    for(uint32_t i = 1; i <= GPU_TIMER_LATENCY; i++) {
+        read_slot((m_slot + i) % GPU_TIMER_LATENCY, true);
+    }
+}
+
+bool GpuTimer::get_stats(GpuTimerPhase phase, struct gpu_timer_stats_t* stats) {
+    const size_t size = m_history_size[phase];
+    if(size == 0) {
+        return false;
+    }
+
+    float sorted[GPU_TIMER_HISTORY_SIZE];
+    memmove(sorted, m_history[phase], size * sizeof(float));
+    std::sort(sorted, sorted + size);
+
+    float sum = 0.0f;
+    for(size_t i = 0; i < size; i++) {
+        sum += sorted[i];
+    }
+
+    size_t latest_index = (m_history_index[phase] + GPU_TIMER_HISTORY_SIZE - 1) % GPU_TIMER_HISTORY_SIZE;
+
+    stats->min_ms = sorted[0];
+    stats->avg_ms = sum / (float)size;
+    stats->p99_ms = sorted[std::min(size - 1, (size_t)((float)size * 0.99f))];
+    stats->latest_ms = m_history[phase][latest_index];
+
+    return true;
+}
+
+void GpuTimer::render_overlay(int x, int y) {
+    if(!m_initialized) {
+        return;
+    }
+
+    constexpr int font_size = 20;
+    constexpr int line_height = 22;
+
+    DrawText("GPU ms    min / avg / p99", x, y, font_size, LIME);
+    y += line_height;
+
+    for(int phase = 0; phase < GPU_PHASE_COUNT; phase++) {
+        struct gpu_timer_stats_t stats;
+        if(!get_stats((GpuTimerPhase)phase, &stats)) {
+            continue;
+        }
+        DrawText(TextFormat("%-8s  %0.2f / %0.2f / %0.2f",
+                    GPU_PHASE_NAMES[phase], stats.min_ms, stats.avg_ms, stats.p99_ms),
+                x, y, font_size, LIME);
+        y += line_height;
+    }
+
+    if(m_csv) {
+        DrawText("Recording CSV", x, y, font_size, RED);
+    }
+}
+
+bool GpuTimer::start_csv(const char* filepath) {
+    this->stop_csv();
+
+    m_csv = fopen(filepath, "w");
+    if(!m_csv) {
+        append_logfile(ERROR, "Failed to open \"%s\" for gpu timings.", filepath);
+        return false;
+    }
+
+    fprintf(m_csv, "frame");
+    for(int phase = 0; phase < GPU_PHASE_COUNT; phase++) {
+        fprintf(m_csv, ",%s_ms", GPU_PHASE_NAMES[phase]);
+    }
+    fprintf(m_csv, "\n");
+
+    this->enabled = true;
+    return true;
+}
+
+void GpuTimer::stop_csv() {
+    if(!m_csv) {
+        return;
+    }
+
+    fclose(m_csv);
+    m_csv = NULL;
+}
+
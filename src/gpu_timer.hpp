@@ -0,0 +1,99 @@
+#ifndef GPU_TIMER_HPP
+#define GPU_TIMER_HPP
+
+#include <cstdint>
+#include <cstdio>
+
+
+// Measures how long the GPU spends on different parts of the frame.
+// Timestamps are read back a few frames late so the cpu never waits for the gpu.
+//
+// NOTE: Raylib batches the draw calls, the batch is flushed when phase begins or ends.
+//       Phases with raylib draw calls (output, editor) may include some submission time.
+
+enum GpuTimerPhase : int {
+    GPU_PHASE_COMPUTE = 0,  // Raymarch compute shader dispatch.
+    GPU_PHASE_OUTPUT,       // Drawing the compute shader results to the screen.
+    GPU_PHASE_IMGUI,
+    GPU_PHASE_EDITOR,
+
+    GPU_PHASE_COUNT
+};
+
+static const char* const GPU_PHASE_NAMES[] = {
+    "Compute",
+    "Output",
+    "ImGui",
+    "Editor"
+};
+
+// How many frames the results are read back late.
+#define GPU_TIMER_LATENCY 4
+
+// How many samples are used for min/avg/p99.
+#define GPU_TIMER_HISTORY_SIZE 128
+
+
+struct gpu_timer_stats_t {
+    float min_ms;
+    float avg_ms;
+    float p99_ms;
+    float latest_ms;
+};
+
+
+class GpuTimer {
+    public:
+        GpuTimer() : enabled(false), m_initialized(false), m_csv(NULL) {}
+
+        void init();
+        void quit();
+
+        bool enabled;
+
+        void begin_frame();
+        void begin(GpuTimerPhase phase);
+        void end(GpuTimerPhase phase);
+
+        // Blocks until all results are available.
+        // Useful when the program is not running interactively.
+        void wait_results();
+
+        // Returns false if there are no samples yet.
+        bool get_stats(GpuTimerPhase phase, struct gpu_timer_stats_t* stats);
+
+        // Total number of samples read for the phase.
+        // Can be used to know if there is a new result.
+        uint64_t num_samples(GpuTimerPhase phase) { return m_num_samples[phase]; }
+
+        void render_overlay(int x, int y);
+
+        bool start_csv(const char* filepath);
+        void stop_csv();
+        bool is_csv_open() { return (m_csv != NULL); }
+
+    private:
+
+        uint32_t m_queries[GPU_TIMER_LATENCY][GPU_PHASE_COUNT][2]; // Begin and end timestamp.
+        bool     m_issued[GPU_TIMER_LATENCY][GPU_PHASE_COUNT];
+        uint64_t m_slot_frame[GPU_TIMER_LATENCY];
+
+        float    m_history[GPU_PHASE_COUNT][GPU_TIMER_HISTORY_SIZE];
+        size_t   m_history_size[GPU_PHASE_COUNT];
+        size_t   m_history_index[GPU_PHASE_COUNT];
+        uint64_t m_num_samples[GPU_PHASE_COUNT];
+
+        uint64_t m_frame;
+        uint32_t m_slot;
+        bool     m_initialized;
+
+        FILE* m_csv;
+
+        // If 'wait' is false and the results are not available yet, nothing is read.
+        void read_slot(uint32_t slot, bool wait);
+        void add_sample(GpuTimerPhase phase, float ms);
+};
+
+
+
+#endif
@@ -10,6 +10,9 @@ static constexpr ImVec4 RAY_SETTN_COLOR = ImVec4(1.0, 0.5, 0.7, 1.0);
 static constexpr ImVec4 AO_SETTN_COLOR = ImVec4(0.5, 1.0, 0.5, 1.0);
 static constexpr ImVec4 TR_SETTN_COLOR = ImVec4(0.5, 0.8, 1.0, 1.0);
 
+static constexpr const char*
+    GPU_TIMINGS_CSV_FILE = "gpu_timings.csv";
+
 
 
 void SettingsTab::render(RMSB* rmsb) {
@@ -54,14 +57,31 @@ void SettingsTab::render(RMSB* rmsb) {
     }
 
     ImGui::Checkbox("Auto Reload", &rmsb->auto_reload);
-    if(rmsb->auto_reload) {
-        ImGui::SliderFloat("##AUTO_RELOAD_TIME",
-                &rmsb->auto_reload_delay, 0.2, 10.0,
-                "Auto Reload Time: %0.1f");
+    if(rmsb->auto_reload && !rmsb->file_watcher.is_active()) {
+        ImGui::SameLine();
+        ImGui::TextColored(ImVec4(1.0, 0.3, 0.3, 1.0), "| Not available");
     }
 
     ImGui::Checkbox("View Functions", &rmsb->gui.view_functions);
     ImGui::Checkbox("Show FPS", &rmsb->show_fps);
+    ImGui::Checkbox("Show GPU Timings", &rmsb->show_gpu_timings);
+    if(rmsb->show_gpu_timings) {
+        ImGui::SameLine();
+        if(!rmsb->gpu_timer.is_csv_open()) {
+            if(ImGui::SmallButton("Record CSV")) {
+                if(rmsb->gpu_timer.start_csv(GPU_TIMINGS_CSV_FILE)) {
+                    rmsb->loginfo(GREEN, "Writing GPU timings to \"%s\"", GPU_TIMINGS_CSV_FILE);
+                }
+                else {
+                    rmsb->loginfo(RED, "Failed to open \"%s\"", GPU_TIMINGS_CSV_FILE);
+                }
+            }
+        }
+        else
+        if(ImGui::SmallButton("Stop CSV")) {
+            rmsb->gpu_timer.stop_csv();
+        }
+    }
     ImGui::Checkbox("Show Infolog", &rmsb->show_infolog);
     ImGui::Checkbox("Show Editor", &Editor::get_instance().open);
 
@@ -89,6 +109,12 @@ void SettingsTab::render(RMSB* rmsb) {
         ImGui::SameLine();
         ImGui::TextColored(RAY_SETTN_COLOR, "- Ray length");
 
+        ImGui::SliderFloat("##RELAXATION",
+                &rmsb->relaxation, 1.0, 1.9,
+                "%0.2f");
+        ImGui::SameLine();
+        ImGui::TextColored(RAY_SETTN_COLOR, "- Step relaxation");
+
 
 
         ImGui::SliderFloat("##AO_STEP_SIZE",
@@ -119,6 +145,55 @@ void SettingsTab::render(RMSB* rmsb) {
 
 
 
+        bool dynamic_resolution = rmsb->dynamic_resolution;
+        if(ImGui::Checkbox("Dynamic Resolution", &dynamic_resolution)) {
+            rmsb->set_dynamic_resolution(dynamic_resolution);
+        }
+        ImGui::SameLine();
+        ImGui::Text("| %ix%i", rmsb->render_width, rmsb->render_height);
+        if(rmsb->dynamic_resolution) {
+            ImGui::SliderFloat("##DYNAMIC_TARGET_MS",
+                    &rmsb->dynamic_target_ms, 1.0, 50.0,
+                    "Target GPU time: %0.1f ms");
+        }
+
+        if(ImGui::SmallButton("Tune Workgroup Size")) {
+            rmsb->autotune_workgroup_size();
+        }
+        ImGui::SameLine();
+        ImGui::Text("| %ix%i", rmsb->workgroup_size.x, rmsb->workgroup_size.y);
+
+        ImGui::Checkbox("Temporal Accumulation", &rmsb->temporal_accumulation);
+        if(rmsb->temporal_accumulation) {
+            ImGui::SameLine();
+            ImGui::Text("| %i / %i frames", rmsb->get_accum_frames(), rmsb->accum_max_frames);
+            ImGui::SliderInt("##ACCUM_MAX_FRAMES",
+                    &rmsb->accum_max_frames, 1, 1024,
+                    "Max accumulated frames: %i");
+        }
+
+        ImGui::Checkbox("Depth Pre-pass", &rmsb->depth_prepass);
+
+        ImGui::Checkbox("Tiled Rendering", &rmsb->tiled_rendering);
+        if(rmsb->tiled_rendering) {
+            ImGui::SameLine();
+            ImGui::Text("| %i / %i tiles", rmsb->get_tiles_done(), rmsb->get_num_tiles());
+            ImGui::SliderFloat("##TILE_BUDGET_MS",
+                    &rmsb->tile_budget_ms, 1.0, 50.0,
+                    "GPU budget per frame: %0.1f ms");
+        }
+
+        if(ImGui::Checkbox("Bake Uniforms", &rmsb->bake_uniforms)) {
+            rmsb->reload_shader();
+        }
+        if(rmsb->bake_uniforms) {
+            // Changed values are not used before the shader is compiled again.
+            ImGui::SameLine();
+            if(ImGui::SmallButton("Rebake")) {
+                rmsb->reload_shader();
+            }
+        }
+
         if(ImGui::SliderInt("##FPS_LIMIT",
                 &rmsb->fps_limit, 30, 1000,
                 "%i")) {
@@ -127,6 +202,21 @@ void SettingsTab::render(RMSB* rmsb) {
         ImGui::SameLine();
         ImGui::TextColored(ImVec4(0.8, 0.8, 0.8, 1.0), "- FPS limit");
 
+        ImGui::SliderInt("##SCENE_FPS",
+                &rmsb->scene_fps, 0, 240,
+                (rmsb->scene_fps > 0) ? "%i" : "Every frame");
+        ImGui::SameLine();
+        ImGui::TextColored(ImVec4(0.8, 0.8, 0.8, 1.0), "- Scene FPS");
+
+        ImGui::Separator();
+    }
+
+    if(ImGui::CollapsingHeader("Shader Features")) {
+        for(int i = 0; i < FEATURE_COUNT; i++) {
+            if(ImGui::Checkbox(SHADER_FEATURES[i].name, &rmsb->features[i])) {
+                rmsb->reload_shader();
+            }
+        }
         ImGui::Separator();
     }
 
@@ -0,0 +1,292 @@
+// Dont let EGL include X11 headers, they have conflicting names with raylib.
+// EGL must be included before glad because glad will define its own khrplatform.
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include "libs/glad.h"
+
+#include <raylib.h>
+#include <rlgl.h>
+
+#include <stdio.h>
+#include <cstring>
+#include <chrono>
+#include <vector>
+#include <filesystem>
+
+#include "headless.hpp"
+#include "rmsb.hpp"
+#include "config.hpp"
+#include "error_log.hpp"
+#include "logfile.hpp"
+
+
+struct egl_context_t {
+    EGLDisplay display;
+    EGLContext context;
+};
+
+
+static bool create_egl_context(struct egl_context_t* egl) {
+    egl->display = EGL_NO_DISPLAY;
+    egl->context = EGL_NO_CONTEXT;
+
+    // Prefer surfaceless platform (Mesa) it doesnt need any display server.
+    PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display
+        = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+    if(get_platform_display) {
+        egl->display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    }
+    if(egl->display == EGL_NO_DISPLAY) {
+        egl->display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+
+    EGLint major = 0;
+    EGLint minor = 0;
+    if(!eglInitialize(egl->display, &major, &minor)) {
+        fprintf(stderr, "%s: Failed to initialize EGL (0x%X)\n", __func__, eglGetError());
+        return false;
+    }
+
+    if(!eglBindAPI(EGL_OPENGL_API)) {
+        fprintf(stderr, "%s: EGL doesnt support desktop OpenGL.\n", __func__);
+        eglTerminate(egl->display);
+        return false;
+    }
+
+    const EGLint context_attribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 4,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+
+    // Nothing is drawn to a surface so config is not needed. (EGL_KHR_no_config_context)
+    egl->context = eglCreateContext(egl->display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, context_attribs);
+    if(egl->context == EGL_NO_CONTEXT) {
+        fprintf(stderr, "%s: Failed to create OpenGL 4.3 context (0x%X)\n", __func__, eglGetError());
+        eglTerminate(egl->display);
+        return false;
+    }
+
+    if(!eglMakeCurrent(egl->display, EGL_NO_SURFACE, EGL_NO_SURFACE, egl->context)) {
+        fprintf(stderr, "%s: Failed to make context current (0x%X)\n", __func__, eglGetError());
+        eglDestroyContext(egl->display, egl->context);
+        eglTerminate(egl->display);
+        return false;
+    }
+
+    // Raylib owns the OpenGL function pointers. (see rlgl.h)
+    rlLoadExtensions((void*)eglGetProcAddress);
+    init_device_hash();
+
+    printf("Headless: %s | %s\n",
+            (const char*)glGetString(GL_RENDERER),
+            (const char*)glGetString(GL_VERSION));
+
+    return true;
+}
+
+static void destroy_egl_context(struct egl_context_t* egl) {
+    eglMakeCurrent(egl->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(egl->display, egl->context);
+    eglTerminate(egl->display);
+}
+
+static bool save_frame(const Texture& tex, const std::string& filepath) {
+    std::vector<uint8_t> pixels(tex.width * tex.height * 4);
+
+    glBindTexture(GL_TEXTURE_2D, tex.id);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+    Image image = (Image) {
+        .data = pixels.data(),
+        .width = tex.width,
+        .height = tex.height,
+        .mipmaps = 1,
+        .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8
+    };
+
+    // Texture origin is at bottom left.
+    ImageFlipVertical(&image);
+    return ExportImage(image, filepath.c_str());
+}
+
+
+bool Headless::parse_args(int argc, char** argv, Settings* settings, bool* ok) {
+    *ok = true;
+    if((argc < 2) || (strcmp(argv[1], "--render") != 0)) {
+        return false;
+    }
+
+    settings->shader_filepath = "";
+    settings->output_dir = "./frames";
+    settings->num_frames = 1;
+    settings->width = 1280;
+    settings->height = 720;
+    settings->fps = 60.0f;
+    settings->csv_filepath = "";
+
+    if(argc < 3) {
+        fprintf(stderr, "--render: Shader file is missing.\n");
+        *ok = false;
+        return true;
+    }
+
+    settings->shader_filepath = argv[2];
+
+    for(int i = 3; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = (i+1 < argc) ? argv[i+1] : NULL;
+        if(!value) {
+            fprintf(stderr, "%s: Value expected.\n", arg);
+            *ok = false;
+            break;
+        }
+
+        if(strcmp(arg, "--frames") == 0) {
+            settings->num_frames = atoi(value);
+        }
+        else
+        if(strcmp(arg, "--size") == 0) {
+            if(sscanf(value, "%ix%i", &settings->width, &settings->height) != 2) {
+                fprintf(stderr, "--size: Expected format WxH (for example 1920x1080)\n");
+                *ok = false;
+                break;
+            }
+        }
+        else
+        if(strcmp(arg, "--out") == 0) {
+            settings->output_dir = value;
+        }
+        else
+        if(strcmp(arg, "--fps") == 0) {
+            settings->fps = atof(value);
+        }
+        else
+        if(strcmp(arg, "--csv") == 0) {
+            settings->csv_filepath = value;
+        }
+        else {
+            fprintf(stderr, "Unknown option '%s'\n", arg);
+            *ok = false;
+            break;
+        }
+        i++;
+    }
+
+    if(*ok) {
+        if(settings->num_frames <= 0) {
+            fprintf(stderr, "--frames: Must be at least 1.\n");
+            *ok = false;
+        }
+        if((settings->width <= 0) || (settings->height <= 0)) {
+            fprintf(stderr, "--size: Width and height must be larger than 0.\n");
+            *ok = false;
+        }
+        if(settings->fps <= 0.0f) {
+            fprintf(stderr, "--fps: Must be larger than 0.\n");
+            *ok = false;
+        }
+    }
+
+    return true;
+}
+
+
+int Headless::render(RMSB* rmsb, const INIReader& ini, const Settings& settings) {
+    if(!FileExists(settings.shader_filepath.c_str())) {
+        fprintf(stderr, "\"%s\" Does not exist.\n", settings.shader_filepath.c_str());
+        return 1;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(settings.output_dir, ec);
+    if(ec) {
+        fprintf(stderr, "Failed to create directory \"%s\": %s\n",
+                settings.output_dir.c_str(), ec.message().c_str());
+        return 1;
+    }
+
+    struct egl_context_t egl;
+    if(!create_egl_context(&egl)) {
+        return 1;
+    }
+
+    rmsb->shader_filepath = settings.shader_filepath;
+    rmsb->set_default_values();
+    Config::read_render_settings(ini, rmsb);
+
+    rmsb->monitor_width = settings.width;
+    rmsb->monitor_height = settings.height;
+    rmsb->render_texture = rmsb->create_empty_texture(settings.width, settings.height, GL_RGBA16F);
+    rmsb->render_width = settings.width;
+    rmsb->render_height = settings.height;
+
+    rmsb->gpu_timer.init();
+    rmsb->render_params_ubo = rmsb->create_ubo(RENDER_PARAMS_BINDING, sizeof(struct render_params_t));
+    rmsb->gpu_timer.enabled = true;
+    if(!settings.csv_filepath.empty()
+    && !rmsb->gpu_timer.start_csv(settings.csv_filepath.c_str())) {
+        fprintf(stderr, "Failed to open \"%s\"\n", settings.csv_filepath.c_str());
+    }
+
+    char* shader_code = LoadFileText(settings.shader_filepath.c_str());
+    InternalLib::get_instance().create_source();
+    rmsb->reload_shader_from(shader_code);
+    rmsb->update_shader_reload(true);
+    UnloadFileText(shader_code);
+
+    int exit_code = 0;
+
+    if(rmsb->compute_shader == 0) {
+        fprintf(stderr, "\"%s\" Failed to compile:\n", settings.shader_filepath.c_str());
+        ErrorLog::get_instance().print();
+        exit_code = 1;
+        goto done;
+    }
+
+    {
+        const double time_step = 1.0 / settings.fps;
+        double render_ms = 0.0;
+
+        for(int frame = 0; frame < settings.num_frames; frame++) {
+            rmsb->time = frame * time_step;
+            rmsb->gpu_timer.begin_frame();
+
+            auto start = std::chrono::steady_clock::now();
+            rmsb->dispatch_compute();
+            glFinish();
+            auto end = std::chrono::steady_clock::now();
+            render_ms += std::chrono::duration<double, std::milli>(end - start).count();
+
+            std::string filepath = TextFormat("%s/frame_%05i.png", settings.output_dir.c_str(), frame);
+            if(!save_frame(rmsb->render_texture, filepath)) {
+                fprintf(stderr, "Failed to write \"%s\"\n", filepath.c_str());
+                exit_code = 1;
+                break;
+            }
+        }
+
+        printf("Rendered %i frames (%ix%i) in %0.2f ms, %0.3f ms/frame\n",
+                settings.num_frames, settings.width, settings.height,
+                render_ms, render_ms / settings.num_frames);
+
+        rmsb->gpu_timer.wait_results();
+        struct gpu_timer_stats_t stats;
+        if(rmsb->gpu_timer.get_stats(GPU_PHASE_COMPUTE, &stats)) {
+            printf("GPU compute: min %0.3f ms, avg %0.3f ms, p99 %0.3f ms\n",
+                    stats.min_ms, stats.avg_ms, stats.p99_ms);
+        }
+    }
+
+done:
+    rmsb->unload_gl_resources();
+    InternalLib::get_instance().clear_uniforms();
+    destroy_egl_context(&egl);
+    return exit_code;
+}
+
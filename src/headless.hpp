@@ -0,0 +1,40 @@
+#ifndef HEADLESS_HPP
+#define HEADLESS_HPP
+
+#include <string>
+
+
+class RMSB;
+class INIReader;
+
+
+// Headless mode renders the shader without window, gui or editor.
+// OpenGL context is created with EGL (surfaceless) so it works on machines without display.
+// Usage: rmsb --render <shader.glsl> --frames N --size WxH --out <directory> --csv <timings.csv>
+
+namespace Headless
+{
+
+    struct Settings {
+        std::string shader_filepath;
+        std::string output_dir;
+        int   num_frames;
+        int   width;
+        int   height;
+        float fps; // Used for the time step between frames.
+        std::string csv_filepath; // GPU timings are written here if not empty.
+    };
+
+
+    // Returns true if 'argv' requested headless mode.
+    // On error 'ok' is set to false and the reason is printed.
+    bool parse_args(int argc, char** argv, Settings* settings, bool* ok);
+
+    // Returns exit code for the program.
+    int render(RMSB* rmsb, const INIReader& ini, const Settings& settings);
+
+};
+
+
+
+#endif
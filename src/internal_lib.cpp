@@ -1,11 +1,15 @@
 
 #include <string>
 #include <cstring>
+#include <vector>
+#include <algorithm>
+#include <cctype>
 
 #include <fstream>
 
 #include "imgui.h"
 #include "internal_lib.hpp"
+#include "shader_util.hpp"
 
 
 static const struct u8col_t UCOLOR_INFO    = (u8col_t){ 130, 50, 60 };
@@ -55,8 +59,148 @@ static bool str_contains(const std::string& str, size_t pos, const char* part, s
     return isfound;
 }
 
+static bool is_identifier_char(char c) {
+    return isalnum((unsigned char)c) || (c == '_');
+}
+
+static bool has_identifier(const std::string& code, const std::string& name) {
+    size_t pos = 0;
+    while((pos = code.find(name, pos)) != std::string::npos) {
+        const size_t end = pos + name.size();
+        if(((pos == 0) || !is_identifier_char(code[pos-1]))
+        && ((end >= code.size()) || !is_identifier_char(code[end]))) {
+            return true;
+        }
+        pos = end;
+    }
+    return false;
+}
+
+static std::string remove_comments(const std::string& code) {
+    std::string result;
+    result.reserve(code.size());
+
+    for(size_t i = 0; i < code.size(); i++) {
+        if(code.compare(i, 2, "//") == 0) {
+            i = code.find('\n', i);
+            if(i == std::string::npos) {
+                break;
+            }
+        }
+        else
+        if(code.compare(i, 2, "/*") == 0) {
+            i = code.find("*/", i+2);
+            if(i == std::string::npos) {
+                break;
+            }
+            i++;
+            continue;
+        }
+        result += code[i];
+    }
+
+    return result;
+}
+
+// Document name is the first line of the function: "float Func(vec3 p)"
+static std::string get_function_name(const Document& doc) {
+    size_t end = doc.name.find('(');
+    if(end == std::string::npos) {
+        return "";
+    }
+    while((end > 0) && (doc.name[end-1] == ' ')) {
+        end--;
+    }
+    size_t begin = end;
+    while((begin > 0) && is_identifier_char(doc.name[begin-1])) {
+        begin--;
+    }
+    return doc.name.substr(begin, end - begin);
+}
+
+static int count_brackets(const std::string& line) {
+    int depth = 0;
+    for(char c : line) {
+        if(c == '{') { depth++; }
+        else
+        if(c == '}') { depth--; }
+    }
+    return depth;
+}
+
+static bool starts_with(const std::string& line, const char* str) {
+    size_t i = line.find_first_not_of(" \t");
+    return (i != std::string::npos) && (line.compare(i, strlen(str), str) == 0);
+}
+
+void InternalLib::add_library_line(const std::string& line) {
+    struct declaration_parser_t& p = m_decl_parser;
+
+    this->library.push_back((struct library_part_t) { "", "", NULL, false });
+    struct library_part_t& part = this->library.back();
+
+    // Workgroup size is defined with the user code.
+    if(line.find("local_size_x") == std::string::npos) {
+        part.code = line + '\n';
+    }
+
+    const int depth = p.depth;
+    p.depth += count_brackets(line);
+
+    if(p.in_macro || ((depth == 0) && starts_with(line, "#"))) {
+        part.declaration = line + '\n';
+        p.in_macro = (line.back() == '\\');
+        return;
+    }
+
+    if(p.in_declaration) {
+        part.declaration = line + '\n';
+        p.in_declaration = (p.depth > 0);
+        return;
+    }
+
+    if((depth > 0) || starts_with(line, "//") || starts_with(line, "}") || starts_with(line, "{")) {
+        return; // Function body or comment.
+    }
+
+    if(starts_with(line, "layout") || starts_with(line, "uniform")) {
+        part.declaration = line + '\n';
+        p.in_declaration = (p.depth > 0);
+        return;
+    }
+
+    const size_t paren = line.find('(');
+    const size_t semicolon = line.rfind(';');
+    if((semicolon != std::string::npos) && (line.find('{') == std::string::npos)) {
+        // Global variable or prototype.
+        // Variables are initialized only in the library.
+        const size_t assign = line.find('=');
+        if((assign != std::string::npos) && !starts_with(line, "const")) {
+            size_t end = assign;
+            while((end > 0) && (line[end-1] == ' ')) {
+                end--;
+            }
+            part.declaration = line.substr(0, end) + ";\n";
+        }
+        else {
+            part.declaration = line + '\n';
+            part.is_prototype = (paren != std::string::npos);
+        }
+    }
+    else
+    if((paren != std::string::npos) && !starts_with(line, "void main")) {
+        // Function definition, only the prototype is declared.
+        const size_t end = line.rfind(')', line.find('{'));
+        if(end != std::string::npos) {
+            part.declaration = line.substr(0, end+1) + ";\n";
+        }
+    }
+}
+
 void InternalLib::create_source() {
     this->source = "";
+    this->library.clear();
+    m_decl_parser = (struct declaration_parser_t) { 0, false, false };
     this->documents.clear();
     this->clear_uniforms();
 
@@ -86,7 +230,7 @@ void InternalLib::create_source() {
     // is parsed in this kind of way is because it is convenient to have the documents 
     // inside the tool itself.
 
-    std::ifstream file("internal.glsl");
+    std::ifstream file(INTERNAL_LIB_FILEPATH);
     std::string line;
 
     bool read_code = false;
@@ -160,6 +304,7 @@ void InternalLib::create_source() {
         }
 
         this->source += line + '\n';
+        this->add_library_line(line);
     }
 
     // This will reset the line number count.
@@ -210,6 +355,23 @@ void InternalLib::add_document(const char* code, const char* description, struct
 
     this->source += code;
     this->documents.push_back(document);
+
+    // Structures are declared fully, functions only with prototype.
+    // Functions which user must define are always needed.
+    struct library_part_t part = (struct library_part_t) { code, "", &this->documents.back(), false };
+    if(strncmp(code, "struct", 6) == 0) {
+        part.declaration = code;
+        part.document = NULL;
+    }
+    else
+    if(!document.name.empty() && (document.name.back() == ';')) {
+        part.declaration = document.name + '\n';
+        part.document = NULL;
+    }
+    else {
+        part.declaration = document.name + ";\n";
+    }
+    this->library.push_back(part);
 }
         
 void InternalLib::add_info(const char* title, const char* description, struct u8col_t color, const char* link) {
@@ -237,8 +399,92 @@ void InternalLib::add_info(const char* title, const char* description, struct u8
     this->documents.push_back(document);
 }
 
-const std::string InternalLib::get_source() {
-    return this->source;
+std::string InternalLib::get_uniform_declarations(bool as_constants) {
+    std::string code = "";
+    for(Uniform& u : this->uniforms) {
+        if(u.type == UniformDataType::TEXTURE) {
+            continue;
+        }
+        if(!as_constants) {
+            code += get_uniform_code_line(&u) + '\n';
+            continue;
+        }
+
+        // Same values as what 'RMSB::set_compute_uniforms' would set.
+        const char* type = UNIFORM_GLSL_TYPES_STR[u.type];
+        code += "const " + std::string(type) + " " + u.name.c_str() + " = ";
+        switch(u.type) {
+            case UniformDataType::RGBA:
+                code += "vec4(" + glsl_float(u.values[0]) + ", " + glsl_float(u.values[1]) + ", "
+                                + glsl_float(u.values[2]) + ", " + glsl_float(u.values[3]) + ");\n";
+                break;
+
+            case UniformDataType::XYZ:
+                code += "vec3(" + glsl_float(-u.values[0]) + ", " + glsl_float(u.values[1]) + ", "
+                                + glsl_float(u.values[2]) + ");\n";
+                break;
+
+            default:
+                code += glsl_float(u.values[0]) + ";\n";
+                break;
+        }
+    }
+    return code;
+}
+
+void InternalLib::find_used_documents(const std::string& code, std::vector<const Document*>* used) {
+    // Follow the calls to internal functions.
+    std::vector<const std::string*> queue = { &code };
+
+    while(!queue.empty()) {
+        const std::string* current = queue.back();
+        queue.pop_back();
+
+        for(const Document& doc : this->documents) {
+            if(std::find(used->begin(), used->end(), &doc) != used->end()) {
+                continue;
+            }
+            const std::string func_name = get_function_name(doc);
+            if(func_name.empty() || !has_identifier(*current, func_name)) {
+                continue;
+            }
+
+            used->push_back(&doc);
+            queue.push_back(&doc.code);
+        }
+    }
+}
+
+static int count_lines(const std::string& code) {
+    return (int)std::count(code.begin(), code.end(), '\n');
+}
+
+void InternalLib::get_code(const std::string& user_code, struct library_code_t* out) {
+    out->library.clear();
+    out->declarations.clear();
+    out->num_stripped_lines = 0;
+    out->num_stripped_declarations = 0;
+
+    // Code outside of the documents may call library functions too.
+    std::string root_code = remove_comments(user_code);
+    for(const struct library_part_t& part : this->library) {
+        if(!part.document && !part.is_prototype) {
+            root_code += part.code;
+        }
+    }
+
+    std::vector<const Document*> used;
+    this->find_used_documents(remove_comments(root_code), &used);
+
+    for(const struct library_part_t& part : this->library) {
+        if(part.document && (std::find(used.begin(), used.end(), part.document) == used.end())) {
+            out->num_stripped_lines += count_lines(part.code);
+            out->num_stripped_declarations += count_lines(part.declaration);
+            continue;
+        }
+        out->library += part.code;
+        out->declarations += part.declaration;
+    }
 }
         
 
@@ -309,6 +555,7 @@ void InternalLib::add_uniform(Uniform* u) {
 
 void InternalLib::clear() {
     this->source.clear();
+    this->library.clear();
     this->documents.clear();
 }
 
@@ -3,12 +3,15 @@
 
 #include <string>
 #include <list>
+#include <vector>
 #include <unordered_map>
 #include <cstdint>
 
 #include <raylib.h>
 
 
+#define INTERNAL_LIB_FILEPATH "internal.glsl"
+
 #define CUSTOM_UNIFORMS_TAG_BEGIN "//__tag__UNIFORMS_BEGIN\n"
 #define CUSTOM_UNIFORMS_TAG_END   "//__tag__UNIFORMS_END\n"
 
@@ -48,7 +51,7 @@ static const char* const UNIFORM_GLSL_TYPES_STR[] = {
 struct Uniform {
     UniformDataType type;
     std::string name;
-    int         location; // NOT NEEDED
+    int         location; // Location in the current compute shader, set after it is loaded.
     
 
     // 0:       Used for floating point value,
@@ -90,6 +93,14 @@ struct Document {
     struct u8col_t color;
 };
 
+// Internal library code which is needed by the user shader.
+struct library_code_t {
+    std::string library;      // Definitions, compiled as its own shader object.
+    std::string declarations; // Compiled with the user code.
+    int num_stripped_lines;         // Lines left out from 'library' because nothing uses them.
+    int num_stripped_declarations;  // Lines left out from 'declarations'.
+};
+
 class InternalLib {
     public:
         static InternalLib& get_instance() {
@@ -103,7 +114,22 @@ class InternalLib {
         void add_uniform      (Uniform* u);
         void remove_uniform   (Uniform* u);
         
-        const std::string get_source();
+        const std::string& get_source() { return this->source; }
+
+        // The library can be compiled once as its own shader object
+        // and linked with the user code. See 'RMSB::reload_shader_from'
+        //
+        // Library code is without custom uniforms and the workgroup layout.
+        // Declarations are the defines, uniforms, structures, global variables
+        // and function prototypes of the library.
+        //
+        // Functions which are not called from 'user_code' directly
+        // or through other library functions are left out.
+        void get_code(const std::string& user_code, struct library_code_t* out);
+        
+        // Declarations for custom uniforms.
+        // With 'as_constants' the current values are baked in as constants.
+        std::string get_uniform_declarations(bool as_constants = false);
 
         std::list<Document> documents;
         std::list<Uniform> uniforms; // WARNING: Do NOT clear the uniform list directly.
@@ -128,6 +154,28 @@ class InternalLib {
         std::string get_uniform_code_line(Uniform* u);
 
         std::string source;
+
+        // Library split to parts which can be left out.
+        struct library_part_t {
+            std::string code;
+            std::string declaration;
+            const Document* document; // NULL if always needed.
+            bool        is_prototype; // Prototype doesnt make the function used.
+        };
+        std::vector<struct library_part_t> library;
+
+        // Finds the function documents called from 'code' directly or through other functions.
+        void find_used_documents(const std::string& code, std::vector<const Document*>* used);
+
+        // State for parsing declarations from the code outside of documents.
+        struct declaration_parser_t {
+            int  depth;          // Curly bracket depth.
+            bool in_declaration; // Inside uniform block.
+            bool in_macro;       // Macro continues to next line.
+        } m_decl_parser;
+
+        void add_library_line(const std::string& line);
+
         InternalLib() {}
 };
 
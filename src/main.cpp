@@ -5,13 +5,10 @@
 #include "logfile.hpp"
 
 #include "config.hpp"
+#include "headless.hpp"
 #include "libs/glad.h"
 
 
-static constexpr const char* 
-    CONFIG_FILE = "rmsb.ini";
-
-
 void key_inputs(RMSB* rmsb) {
 
     InputHandler::update_input_key(rmsb);
@@ -36,6 +33,7 @@ void loop(RMSB* rmsb) {
 
     while(!WindowShouldClose() && rmsb->running) {
         key_inputs(rmsb);
+        rmsb->gpu_timer.begin_frame();
         BeginDrawing();
         ClearBackground((Color){ 10, 10, 10, 255 });
        
@@ -48,14 +46,19 @@ void loop(RMSB* rmsb) {
 
         Editor& editor = Editor::get_instance();
         if(!rmsb->allow_camera_input) {
-            editor.update(rmsb);
+            editor.update();
         }
+        rmsb->gpu_timer.begin(GPU_PHASE_EDITOR);
         editor.render(rmsb);
+        rmsb->gpu_timer.end(GPU_PHASE_EDITOR);
         rmsb->render_3d();
        
         if(rmsb->show_fps) {
             DrawFPS(10, GetScreenHeight()-20);
         }
+        if(rmsb->show_gpu_timings) {
+            rmsb->gpu_timer.render_overlay(10, GetScreenHeight()-20 - 6*22);
+        }
 
 
         rmsb->input_key = 0;
@@ -119,15 +122,43 @@ void init_all(RMSB* rmsb) {
     rmsb->reload_shader();
 }
 
+int render_headless(const Headless::Settings& settings) {
+    INIReader ini_reader(CONFIG_FILE);
+    if(ini_reader.ParseError() < 0) {
+        fprintf(stderr, "%s: Failed to load '%s'\n",
+                __func__, CONFIG_FILE);
+        return 1;
+    }
+
+    assign_logfile("rmsb.log");
+    
+    RMSB rmsb;
+    int exit_code = Headless::render(&rmsb, ini_reader, settings);
+    
+    close_logfile();
+    return exit_code;
+}
+
 int main(int argc, char** argv) {
 
+    Headless::Settings headless_settings;
+    bool headless_args_ok = true;
+    if(Headless::parse_args(argc, argv, &headless_settings, &headless_args_ok)) {
+        if(!headless_args_ok) {
+            return 1;
+        }
+        return render_headless(headless_settings);
+    }
+
     if(argc != 2) {
         fprintf(stderr, 
                 "\033[36m[RaymarchSandbox]\033[0m\n"
                 "Usage: %s <shader.glsl>\n"
+                "       %s --render <shader.glsl> [--frames N] [--size WxH] [--out directory] [--fps F] [--csv timings.csv]\n"
                 "\033[90m> Already existing file is read, otherwise empty template is created\n"
+                "\033[90m> --render writes frames as png images without opening a window.\n"
                 "\033[90m> To get started, reading examples/intro.glsl and other examples is recommended.\033[0m\n"
-                , argv[0]);
+                , argv[0], argv[0]);
         return 1;
     }
 
@@ -1,100 +1,636 @@
 
+#include <raylib.h>
+
+#include <cstdio>
+#include <cctype>
 #include <vector>
-#include <string_view>
-#include <cstring>
+#include <map>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
 
 #include "preproc.hpp"
+#include "shader_util.hpp"
+#include "error_log.hpp"
+#include "logfile.hpp"
+
+
+
+// Included files are cached by their full path.
+// 'code' has the include directives replaced with empty lines.
+struct include_t {
+    size_t      index; // In 'code', where the included file goes.
+    int         row;   // Row of the directive, starting from 1.
+    std::string path;
+};
+
+struct module_t {
+    std::filesystem::file_time_type mtime;
+    uintmax_t   size;
+    int         source;  // '#line' source string number.
+    std::string code;
+    std::string defines; // From the built in tags. (RM_VOLUME_MAP)
+    std::vector<struct include_t> includes;
+};
+
+static std::map<std::string, struct module_t> g_modules;
+static std::vector<std::string> g_source_names; // Index is (source - SHADER_SOURCE_INCLUDE)
+
+
+// Material macros for the copy of map(), see 'Preproc::get_distance_map'
+// Values which DistMaterial doesnt have are written to unused variables.
+static constexpr const char* DISTANCE_MAP_DEFINES =
+    "#undef Material\n"
+    "#undef Mdiffuse\n"
+    "#undef Mspecular\n"
+    "#undef Mdistance\n"
+    "#undef MreflectN\n"
+    "#undef Mopaque\n"
+    "#undef Mcanglow\n"
+    "#undef MtextureID\n"
+    "#define Material DistMaterial\n"
+    "#define EmptyMaterial _DistEmptyMaterial\n"
+    "#define Mdiffuse(m)     _unused_v3\n"
+    "#define Mspecular(m)    _unused_v3\n"
+    "#define Mdistance(m)    m.x\n"
+    "#define MreflectN(m)    m.z\n"
+    "#define Mopaque(m)      m.y\n"
+    "#define Mcanglow(m)     m.w\n"
+    "#define MtextureID(m)   _unused_f\n";
 
+static constexpr const char* DISTANCE_MAP_UNUSED = " vec3 _unused_v3; float _unused_f;";
 
+static constexpr const char* DISTANCE_MAP_FALLBACK =
+    "DistMaterial map_dist(vec3 p) {\n"
+    "    Material m = map(p);\n"
+    "    return DistMaterial(Mdistance(m), Mopaque(m), MreflectN(m), Mcanglow(m));\n"
+    "}\n";
 
-struct tag_t {
-    size_t index;
-    size_t end;
-    size_t size;
-    const char* pstr; // <-- NOTE: This is _not_ null-terminated.
+// Library functions and types which need the full Material.
+static const char* const DISTANCE_MAP_UNSUPPORTED[] = {
+    "mat4x3", "LightPoint", "LightDirectional"
 };
 
+// Members of RAY_T which are full Materials. (Ray.mat)
+static const char* const DISTANCE_MAP_UNSUPPORTED_MEMBERS[] = {
+    "mat", "closest_mat"
+};
+
+static bool g_fallback_logged = false; // Logged once until map() can be copied again.
+
+
+// Finds the include directives from 'code' and removes them.
+// Only the line contents are removed so the row numbers dont change.
+static void parse_includes(std::string* code, const std::filesystem::path& dir,
+        std::vector<struct include_t>* includes, std::string* outdef) {
+    size_t line_begin = 0;
+    int row = 1;
+
+    while(line_begin < code->size()) {
+        size_t line_end = code->find('\n', line_begin);
+        if(line_end == std::string::npos) {
+            line_end = code->size();
+        }
+
+        size_t i = code->find_first_not_of(" \t", line_begin);
+        if((i < line_end) && (code->compare(i, 8, "#include") == 0)) {
+            i = code->find_first_not_of(" \t", i + 8);
+            if(i >= line_end) {
+                i = line_end;
+            }
+            const std::string arg = code->substr(i, line_end - i);
+
+            if((arg.size() >= 2) && (arg[0] == '"')) {
+                const size_t quote_end = arg.find('"', 1);
+                if(quote_end != std::string::npos) {
+                    const std::string path = (dir / arg.substr(1, quote_end - 1)).lexically_normal().string();
+                    includes->push_back((struct include_t) { line_begin, row, path });
+                }
+            }
+            else
+            if(arg.compare(0, 13, "RM_VOLUME_MAP") == 0) {
+                *outdef += "\n#define VMAP_ENABLED 1\n";
+            }
+
+            code->erase(line_begin, line_end - line_begin);
+            line_end = line_begin;
+        }
+
+        line_begin = line_end + 1;
+        row++;
+    }
+}
+
+// Returns NULL if the file cant be read.
+static const struct module_t* get_module(const std::string& path) {
+    std::error_code ec;
+    const std::filesystem::file_time_type mtime = std::filesystem::last_write_time(path, ec);
+    const uintmax_t size = ec ? 0 : std::filesystem::file_size(path, ec);
+    if(ec) {
+        return NULL;
+    }
+
+    auto it = g_modules.find(path);
+    if(it != g_modules.end()) {
+        if((it->second.mtime == mtime) && (it->second.size == size)) {
+            return &it->second;
+        }
+    }
+
+    struct module_t& module = g_modules[path];
+    if(it == g_modules.end()) {
+        module.source = SHADER_SOURCE_INCLUDE + g_source_names.size();
+        g_source_names.push_back(path);
+    }
+
+    std::ifstream file(path);
+    if(!file.is_open()) {
+        return NULL;
+    }
+
+    std::stringstream stream;
+    stream << file.rdbuf();
+
+    module.mtime = mtime;
+    module.size = size;
+    module.code = stream.str();
+    if(module.code.empty() || (module.code.back() != '\n')) {
+        module.code += '\n';
+    }
+    module.includes.clear();
+    module.defines.clear();
+    parse_includes(&module.code, std::filesystem::path(path).parent_path(), &module.includes, &module.defines);
+    return &module;
+}
 
-static void find_all_tags(const std::string* shader_code, const char* tag, std::vector<struct tag_t>* out) {
-   
+// Adds 'code' to 'out' with the includes expanded.
+// 'source' is the source string number of 'code', it is restored after each included file.
+static void expand_includes(const std::string& code, const std::vector<struct include_t>& includes,
+        int source, std::string* out, std::string* outdef, std::vector<std::string>* included) {
     size_t pos = 0;
 
-    while(true) {
-        size_t i = shader_code->find(tag, pos);
-        if(i == std::string::npos) {
-            break;
+    for(const struct include_t& inc : includes) {
+        out->append(code, pos, inc.index - pos);
+        pos = inc.index;
+
+        // Each file is included only once, this also stops include loops.
+        if(std::find(included->begin(), included->end(), inc.path) != included->end()) {
+            continue;
         }
+        included->push_back(inc.path);
 
-        size_t next_newln_i = shader_code->find("\n", i, 1);
-        size_t next_space_i = shader_code->find(" ", i, 1);
-        for(size_t j = next_space_i; j < next_newln_i; j++) {
-            if((*shader_code)[j] != ' ') {
-                next_space_i = j;
-                break;
+        const struct module_t* module = get_module(inc.path);
+        if(!module) {
+            ErrorLog::get_instance().add(
+                    TextFormat("%i:%i(1): error: Cannot open included file \"%s\"",
+                        source, (source == SHADER_SOURCE_USER) ? (inc.row - 1) : inc.row, inc.path.c_str()));
+            continue;
+        }
+
+        *outdef += module->defines;
+        *out += TextFormat("#line 1 %i\n", module->source);
+        expand_includes(module->code, module->includes, module->source, out, outdef, included);
+
+        // Rows of the user code start from 0, see SHADER_LINE_USER
+        *out += TextFormat("#line %i %i", (source == SHADER_SOURCE_USER) ? inc.row : (inc.row + 1), source);
+    }
+
+    out->append(code, pos, std::string::npos);
+}
+
+
+static bool is_identifier_char(char c) {
+    return isalnum((unsigned char)c) || (c == '_');
+}
+
+// Finds 'name' as a whole word.
+static size_t find_identifier(const std::string& code, const std::string& name, size_t pos = 0) {
+    while((pos = code.find(name, pos)) != std::string::npos) {
+        const size_t end = pos + name.size();
+        if(((pos == 0) || !is_identifier_char(code[pos-1]))
+        && ((end >= code.size()) || !is_identifier_char(code[end]))) {
+            return pos;
+        }
+        pos = end;
+    }
+    return std::string::npos;
+}
+
+// Comments are replaced with spaces so the positions and rows dont change.
+static std::string blank_comments(const std::string& code) {
+    std::string result = code;
+    for(size_t i = 0; i < result.size(); i++) {
+        size_t end = i;
+        if(result.compare(i, 2, "//") == 0) {
+            end = result.find('\n', i);
+        }
+        else
+        if(result.compare(i, 2, "/*") == 0) {
+            end = result.find("*/", i+2);
+            end = (end == std::string::npos) ? end : (end + 2);
+        }
+        else {
+            continue;
+        }
+
+        end = std::min(end, result.size());
+        for(; i < end; i++) {
+            if(result[i] != '\n') {
+                result[i] = ' ';
             }
         }
+        i--;
+    }
+    return result;
+}
 
-        if(next_space_i != std::string::npos
-        && next_newln_i != std::string::npos
-        && next_space_i < next_newln_i) {
-            out->push_back(
-                    (struct tag_t) {
-                        .index = i,
-                        .end = next_newln_i,
-                        .size = (next_newln_i - next_space_i),
-                        .pstr = &((*shader_code)[next_space_i])
-                    }
-                    );
+// Preprocessor lines are replaced with spaces.
+static std::string blank_directives(std::string code) {
+    size_t line_begin = 0;
+    while(line_begin < code.size()) {
+        size_t line_end = code.find('\n', line_begin);
+        if(line_end == std::string::npos) {
+            line_end = code.size();
+        }
+        const size_t i = code.find_first_not_of(" \t", line_begin);
+        if((i < line_end) && (code[i] == '#')) {
+            std::fill(code.begin() + line_begin, code.begin() + line_end, ' ');
         }
-        pos = i+1;
+        line_begin = line_end + 1;
     }
+    return code;
 }
 
+// Identifier before 'pos' or empty string.
+static std::string identifier_before(const std::string& code, size_t pos, size_t* begin = NULL) {
+    size_t end = pos;
+    while((end > 0) && isspace((unsigned char)code[end-1])) {
+        end--;
+    }
+    size_t i = end;
+    while((i > 0) && is_identifier_char(code[i-1])) {
+        i--;
+    }
+    if(begin) {
+        *begin = i;
+    }
+    return code.substr(i, end - i);
+}
 
-static bool compare(
-        const char* str_A, size_t size_A,
-        const char* str_B, size_t size_B
-){
-    if(size_B == 0) {
-        size_B = strlen(str_B);
+// Names of the functions and global variables which use Material are added to 'names'
+// 'statement' is the code at depth 0 before ';' or '{'
+static void find_material_names(const std::string& statement, std::vector<std::string>* names) {
+    if(find_identifier(statement, "Material") == std::string::npos) {
+        return;
     }
 
-    bool result = false;
-    if(size_A != size_B) {
-        goto skip;
+    const size_t paren = statement.find('(');
+    if(paren != std::string::npos) {
+        const std::string name = identifier_before(statement, paren);
+        if(name != "map") {
+            names->push_back(name);
+        }
+        return;
     }
 
-    for(size_t i = 0; i < size_A; i++) {
-        if(str_A[i] != str_B[i]) {
-            goto skip;
+    for(size_t i = 0; i < statement.size();) {
+        if(!is_identifier_char(statement[i])) {
+            i++;
+            continue;
         }
+        size_t end = i;
+        while((end < statement.size()) && is_identifier_char(statement[end])) {
+            end++;
+        }
+        const std::string name = statement.substr(i, end - i);
+        if(name != "Material") {
+            names->push_back(name);
+        }
+        i = end;
     }
+}
 
-    result = true;
-skip:
-    return result;
+// Finds 'name' used as a member: "a.name", "a[i].name" or "f().name"
+static bool has_member_access(const std::string& code, const std::string& name) {
+    size_t pos = 0;
+    while((pos = find_identifier(code, name, pos)) != std::string::npos) {
+        size_t dot = code.find_last_not_of(" \t\n", pos - 1);
+        pos += name.size();
+        if((dot == std::string::npos) || (dot == 0) || (code[dot] != '.')) {
+            continue;
+        }
+        const size_t owner = code.find_last_not_of(" \t\n", dot - 1);
+        if((owner != std::string::npos)
+        && (is_identifier_char(code[owner]) || (code[owner] == ']') || (code[owner] == ')'))) {
+            return true;
+        }
+    }
+    return false;
 }
 
+// Reads an identifier starting from the first non space character after 'pos'
+static std::string identifier_after(const std::string& code, size_t pos, size_t* end) {
+    size_t i = code.find_first_not_of(" \t\n", pos);
+    if(i == std::string::npos) {
+        i = code.size();
+    }
+    size_t j = i;
+    while((j < code.size()) && is_identifier_char(code[j])) {
+        j++;
+    }
+    *end = j;
+    return code.substr(i, j - i);
+}
+
+// Names of the variables and parameters declared as Material in 'code'
+// "Material a = x, b;" adds 'a' and 'b'
+static void find_material_variables(const std::string& code, std::vector<std::string>* names) {
+    size_t pos = 0;
+    while((pos = find_identifier(code, "Material", pos)) != std::string::npos) {
+        size_t end = 0;
+        std::string name = identifier_after(code, pos + 8, &end);
+        pos = end;
+
+        while(!name.empty()) {
+            names->push_back(name);
+
+            // Next declarator is after a ',' outside of the parentheses.
+            int depth = 0;
+            for(; pos < code.size(); pos++) {
+                const char c = code[pos];
+                if((c == '(') || (c == '[')) { depth++; }
+                else
+                if((c == ')') || (c == ']')) { depth--; }
+                if((depth < 0) || (c == ';') || (c == '{') || ((c == ',') && (depth == 0))) {
+                    break;
+                }
+            }
+            if((pos >= code.size()) || (code[pos] != ',')) {
+                break;
+            }
+
+            name = identifier_after(code, pos + 1, &end);
+            const size_t next = code.find_first_not_of(" \t\n", end);
+            if((next != std::string::npos) && is_identifier_char(code[next])) {
+                break; // Next parameter with its own type.
+            }
+            pos = end;
+        }
+    }
+}
+
+// Finds 'name' followed by '['
+static bool has_subscript(const std::string& code, const std::string& name) {
+    size_t pos = 0;
+    while((pos = find_identifier(code, name, pos)) != std::string::npos) {
+        pos = code.find_first_not_of(" \t\n", pos + name.size());
+        if((pos != std::string::npos) && (code[pos] == '[')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Returns what map() uses which needs the full Material or empty string if it can be copied.
+// 'map_code' is from the name of map() to the end of its body.
+static std::string find_unsupported(const std::string& body, const std::string& map_code,
+        const std::vector<std::string>& material_names) {
+    for(const char* name : DISTANCE_MAP_UNSUPPORTED) {
+        if(find_identifier(body, name) != std::string::npos) {
+            return name;
+        }
+    }
+    for(const char* name : DISTANCE_MAP_UNSUPPORTED_MEMBERS) {
+        if(has_member_access(body, name)) {
+            return std::string(".") + name;
+        }
+    }
+    for(const std::string& name : material_names) {
+        if(find_identifier(body, name) != std::string::npos) {
+            return name;
+        }
+    }
+
+    // Material is mat4x3, its columns and values dont exist in DistMaterial.
+    // Arrays of Material fall back too.
+    std::vector<std::string> variables;
+    find_material_variables(map_code, &variables);
+    for(const std::string& name : variables) {
+        if(has_subscript(body, name)) {
+            return name + "[]";
+        }
+    }
+
+    // Material constructor with the full values.
+    size_t pos = 0;
+    while((pos = find_identifier(body, "Material", pos)) != std::string::npos) {
+        pos = body.find_first_not_of(" \t\n", pos + 8);
+        if((pos != std::string::npos) && (body[pos] == '(')) {
+            return "Material(...)";
+        }
+    }
+    return "";
+}
+
+// '#line' directives in 'code' are changed to use 'source' as the source string number.
+static std::string set_line_source(std::string code, int source) {
+    size_t line_begin = 0;
+    while(line_begin < code.size()) {
+        size_t line_end = code.find('\n', line_begin);
+        if(line_end == std::string::npos) {
+            line_end = code.size();
+        }
+        const size_t i = code.find_first_not_of(" \t", line_begin);
+        int row = 0;
+        if((i < line_end) && (code.compare(i, 5, "#line") == 0)
+        && (sscanf(code.c_str() + i, "#line %i", &row) == 1)) {
+            const std::string directive = TextFormat("#line %i %i", row, source);
+            code.replace(i, line_end - i, directive);
+            line_end = i + directive.size();
+        }
+        line_begin = line_end + 1;
+    }
+    return code;
+}
+
+std::string Preproc::get_distance_map(const std::string& shader_code, bool* copied) {
+    *copied = false;
+
+    const std::string code = blank_comments(shader_code);
+
+    struct map_function_t {
+        size_t begin;    // After the previous declaration.
+        size_t name;
+        size_t body;     // Opening bracket.
+        size_t end;      // After the closing bracket.
+        int    row;      // Of 'begin'
+        int    source;
+    } map = { 0, 0, 0, 0, 0, 0 };
+
+    std::vector<std::string> material_names;
+    bool found = false;
+    bool supported = true;
 
-void Preproc::process_glsl(std::string* shader_code, std::string* outdef) {
-    std::vector<struct tag_t> include_tags;
+    int    depth = 0;
+    int    row = 0; // Rows of the user code start from 0, see SHADER_LINE_USER
+    int    source = SHADER_SOURCE_USER;
+    size_t statement_begin = 0;
+    int    statement_row = 0;
+    int    statement_source = SHADER_SOURCE_USER;
+    size_t line_begin = 0;
+    bool   in_directive = false;
 
-    find_all_tags(shader_code, "#include", &include_tags);
+    for(size_t i = 0; i < code.size(); i++) {
+        const char c = code[i];
+
+        if(i == line_begin) {
+            const size_t first = code.find_first_not_of(" \t", i);
+            in_directive = (first != std::string::npos) && (code[first] == '#');
+        }
+
+        if(c == '\n') {
+            const std::string line = code.substr(line_begin, i - line_begin);
+            const size_t first = line.find_first_not_of(" \t");
+            int line_row = 0;
+            int line_source = source;
+            if((first != std::string::npos) && (line.compare(first, 5, "#line") == 0)
+            && (sscanf(line.c_str() + first, "#line %i %i", &line_row, &line_source) >= 1)) {
+                row = line_row;
+                source = line_source;
+            }
+            else {
+                row++;
+            }
 
+            if(in_directive && (depth == 0)
+            && ((find_identifier(line, "Material") != std::string::npos)
+             || (find_identifier(line, "mat4x3") != std::string::npos))) {
+                supported = false; // Macros may use the full Material.
+            }
+            line_begin = i + 1;
+            continue;
+        }
+
+        if(in_directive) {
+            continue;
+        }
+
+        if(c == '{') {
+            if(depth == 0) {
+                const std::string statement = blank_directives(code.substr(statement_begin, i - statement_begin));
+                const size_t paren = statement.find('(');
+                size_t name = 0;
+                if(!found && (paren != std::string::npos)
+                && (identifier_before(statement, paren, &name) == "map")
+                && (identifier_before(statement, name) == "Material")) {
+                    found = true;
+                    map.begin = statement_begin;
+                    map.name = statement_begin + name;
+                    map.body = i;
+                    map.row = statement_row;
+                    map.source = statement_source;
+                }
+                else {
+                    find_material_names(statement, &material_names);
+                }
+            }
+            depth++;
+        }
+        else
+        if(c == '}') {
+            depth--;
+            if(depth == 0) {
+                if(found && (map.end == 0)) {
+                    map.end = i + 1;
+                }
+                statement_begin = i + 1;
+                statement_row = row;
+                statement_source = source;
+            }
+        }
+        else
+        if((c == ';') && (depth == 0)) {
+            find_material_names(blank_directives(code.substr(statement_begin, i - statement_begin)), &material_names);
+            statement_begin = i + 1;
+            statement_row = row;
+            statement_source = source;
+        }
+    }
 
-    // This can be now easily expanded to include other files for example.
-    //
+    std::string unsupported = "";
+    if(!found || (map.end == 0)) {
+        unsupported = "map() not found";
+    }
+    else
+    if(!supported) {
+        unsupported = "macro using Material";
+    }
+    else {
+        unsupported = find_unsupported(code.substr(map.body, map.end - map.body),
+                code.substr(map.name, map.end - map.name), material_names);
+    }
 
-    for(size_t i = 0; i < include_tags.size(); i++) {
-        const struct tag_t* tag = &include_tags[i];
-    
-        if(compare(tag->pstr, tag->size, "RM_VOLUME_MAP", 0)) {
-            *outdef += "\n#define VMAP_ENABLED 1\n";
+    if(!unsupported.empty()) {
+        if(!g_fallback_logged) {
+            append_logfile(WARNING, "Distance only map() is not used, map() uses \"%s\"", unsupported.c_str());
+            g_fallback_logged = true;
         }
-        
+        return DISTANCE_MAP_FALLBACK;
+    }
+    g_fallback_logged = false;
+
+    // Rows are the same as in map() but the source string number is not,
+    // errors in the copy are the same as in map() and they are not shown. See 'ErrorLog::add'
+    std::string out = DISTANCE_MAP_DEFINES;
+    out += TextFormat("#line %i %i\n", map.row, SHADER_SOURCE_DISTANCE_MAP);
+    out += blank_directives(code.substr(map.begin, map.name - map.begin));
+    out += "map_dist";
+    out.append(code, map.name + 3, map.body + 1 - (map.name + 3));
+    out += DISTANCE_MAP_UNUSED;
+    out += set_line_source(code.substr(map.body + 1, map.end - (map.body + 1)), SHADER_SOURCE_DISTANCE_MAP);
+    out += '\n';
+    *copied = true;
+    return out;
+}
+
+std::string Preproc::get_distance_map_fallback() {
+    return DISTANCE_MAP_FALLBACK;
+}
+
+
+void Preproc::process_glsl(std::string* shader_code, std::string* outdef,
+        const std::string& filepath, std::vector<std::string>* included) {
+    std::vector<struct include_t> includes;
+    const std::filesystem::path dir = std::filesystem::path(filepath).parent_path();
+    parse_includes(shader_code, dir, &includes, outdef);
+
+    included->clear();
+    if(includes.empty()) {
+        return;
+    }
+
+    std::string code = "";
+    expand_includes(*shader_code, includes, SHADER_SOURCE_USER, &code, outdef, included);
+    *shader_code = std::move(code);
+}
+
+const char* Preproc::get_source_name(int source) {
+    const int index = source - SHADER_SOURCE_INCLUDE;
+    if((index < 0) || (index >= (int)g_source_names.size())) {
+        return NULL;
+    }
+    return g_source_names[index].c_str();
+}
 
-        shader_code->erase(tag->index, tag->end - tag->index);
+std::string Preproc::get_feature_defines(const bool* enabled) {
+    std::string defines = "";
+    for(int i = 0; i < FEATURE_COUNT; i++) {
+        defines += "#define ";
+        defines += SHADER_FEATURES[i].define;
+        defines += enabled[i] ? " 1\n" : " 0\n";
     }
+    return defines;
 }
 
 
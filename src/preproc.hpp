@@ -2,14 +2,69 @@
 #define GLSL_PREPROC_HPP
 
 #include <string>
+#include <vector>
+
+
+// Optional code paths of the internal library.
+// Disabled features are compiled out with defines, see 'internal.glsl'
+enum ShaderFeature : int {
+    FEATURE_REFLECTIONS = 0,
+    FEATURE_TRANSLUCENCY,
+    FEATURE_AO,
+    FEATURE_SHADOWS,
+    FEATURE_TEXTURES,
+    FEATURE_DISTANCE_MAP,
+    FEATURE_COMPACT_MATERIAL,
+
+    FEATURE_COUNT
+};
+
+struct shader_feature_t {
+    const char* name;    // Shown in the gui.
+    const char* define;  // Defined to 0 or 1.
+    const char* ini_key; // In 'render_settings'
+    bool        default_enabled;
+};
+
+static const struct shader_feature_t SHADER_FEATURES[FEATURE_COUNT] = {
+    { "Reflections",       "FEATURE_REFLECTIONS",      "feature_reflections",      true  },
+    { "Translucency",      "FEATURE_TRANSLUCENCY",     "feature_translucency",     true  },
+    { "Ambient Occlusion", "FEATURE_AO",               "feature_ao",               true  },
+    { "Shadows",           "FEATURE_SHADOWS",          "feature_shadows",          true  },
+    { "Texture Mapping",   "FEATURE_TEXTURES",         "feature_textures",         true  },
+    { "Distance Only Map", "FEATURE_DISTANCE_MAP",     "feature_distance_map",     true  },
+    { "Compact Material",  "FEATURE_COMPACT_MATERIAL", "feature_compact_material", false }
+};
 
 
 namespace Preproc 
 { 
 
     // outdef is a pointer to the final shader code
-    // the function will search for #include tags and add code or definitions to *outdef
-    void process_glsl(std::string* shader_code, std::string* outdef);
+    // Expands '#include "file.glsl"' with the file contents, paths are relative to the including file.
+    // Each file is included only once. Included files have their own '#line' source string number.
+    // Files are read again only when their modification time or size has changed.
+    // Built in tags (#include RM_VOLUME_MAP) add definitions to *outdef
+    // 'filepath' is where 'shader_code' is from, 'included' gets all the included files.
+    void process_glsl(std::string* shader_code, std::string* outdef,
+                      const std::string& filepath, std::vector<std::string>* included);
+
+    // Included file for '#line' source string number or NULL.
+    const char* get_source_name(int source);
+
+    // Returns code for 'map_dist()' which is added after the user code.
+    // It is a copy of the user's map() where Material is DistMaterial
+    // (distance, opacity, reflectivity and glow) so shadows, AO, normals
+    // and the ray steps dont compute the colors. See 'internal.glsl'
+    // If map() uses something which cant be copied, map_dist() calls map() instead.
+    // 'copied' is set to true if the code is a copy of map().
+    std::string get_distance_map(const std::string& shader_code, bool* copied);
+
+    // map_dist() which calls map(). Used if the copy failed to compile.
+    std::string get_distance_map_fallback();
+
+    // Defines for all features. 'enabled' must have FEATURE_COUNT elements.
+    std::string get_feature_defines(const bool* enabled);
 
 }
 
@@ -0,0 +1,141 @@
+#include "libs/glad.h"
+
+#include <stdio.h>
+#include <cinttypes>
+#include <vector>
+#include <string>
+#include <filesystem>
+#include <algorithm>
+
+#include "program_cache.hpp"
+#include "logfile.hpp"
+
+
+// File format:
+// uint32_t binary_format
+// uint8_t  binary[...]
+
+
+static bool is_supported() {
+    int num_formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+    return (num_formats > 0);
+}
+
+static std::string get_filepath(uint64_t hash) {
+    char name[32] = { 0 };
+    snprintf(name, sizeof(name), "%016" PRIx64 ".bin", hash);
+    return std::string(PROGRAM_CACHE_DIR) + "/" + name;
+}
+
+// Keep only the newest files.
+static void remove_old_files() {
+    std::error_code ec;
+    std::vector<std::filesystem::directory_entry> files;
+    for(const auto& entry : std::filesystem::directory_iterator(PROGRAM_CACHE_DIR, ec)) {
+        if(entry.is_regular_file(ec)) {
+            files.push_back(entry);
+        }
+    }
+
+    if(files.size() <= PROGRAM_CACHE_MAX_FILES) {
+        return;
+    }
+
+    std::sort(files.begin(), files.end(),
+            [](const auto& a, const auto& b) {
+                std::error_code ec;
+                return a.last_write_time(ec) > b.last_write_time(ec);
+            });
+
+    for(size_t i = PROGRAM_CACHE_MAX_FILES; i < files.size(); i++) {
+        std::filesystem::remove(files[i].path(), ec);
+    }
+}
+
+
+uint32_t ProgramCache::load(uint64_t hash) {
+    if(!is_supported()) {
+        return 0;
+    }
+
+    const std::string filepath = get_filepath(hash);
+    FILE* fp = fopen(filepath.c_str(), "rb");
+    if(!fp) {
+        return 0;
+    }
+
+    uint32_t format = 0;
+    std::vector<uint8_t> binary;
+
+    fseek(fp, 0, SEEK_END);
+    long file_size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    bool read_ok = false;
+    if(file_size > (long)sizeof(format)) {
+        binary.resize(file_size - sizeof(format));
+        read_ok = (fread(&format, sizeof(format), 1, fp) == 1)
+               && (fread(binary.data(), binary.size(), 1, fp) == 1);
+    }
+    fclose(fp);
+
+    if(!read_ok) {
+        append_logfile(WARNING, "\"%s\" is corrupted.", filepath.c_str());
+        std::error_code ec;
+        std::filesystem::remove(filepath, ec);
+        return 0;
+    }
+
+    uint32_t program = glCreateProgram();
+    glProgramBinary(program, format, binary.data(), binary.size());
+
+    int link_ok = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &link_ok);
+    if(!link_ok) {
+        // Driver was probably updated.
+        glDeleteProgram(program);
+        std::error_code ec;
+        std::filesystem::remove(filepath, ec);
+        return 0;
+    }
+
+    return program;
+}
+
+void ProgramCache::store(uint64_t hash, uint32_t program) {
+    if((program == 0) || !is_supported()) {
+        return;
+    }
+
+    int length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if(length <= 0) {
+        return;
+    }
+
+    std::vector<uint8_t> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+
+    std::error_code ec;
+    std::filesystem::create_directories(PROGRAM_CACHE_DIR, ec);
+    if(ec) {
+        append_logfile(ERROR, "Failed to create \"%s\": %s", PROGRAM_CACHE_DIR, ec.message().c_str());
+        return;
+    }
+
+    const std::string filepath = get_filepath(hash);
+    FILE* fp = fopen(filepath.c_str(), "wb");
+    if(!fp) {
+        append_logfile(ERROR, "Failed to open \"%s\" for writing.", filepath.c_str());
+        return;
+    }
+
+    const uint32_t format_u32 = format;
+    fwrite(&format_u32, sizeof(format_u32), 1, fp);
+    fwrite(binary.data(), length, 1, fp);
+    fclose(fp);
+
+    remove_old_files();
+}
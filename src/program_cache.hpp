@@ -0,0 +1,28 @@
+#ifndef PROGRAM_CACHE_HPP
+#define PROGRAM_CACHE_HPP
+
+#include <cstdint>
+
+
+// Linked compute shader programs are saved with glGetProgramBinary
+// so the same shader doesnt need to be compiled again.
+// The key is 'hash_shader_source' of the full code, it includes the device.
+
+#define PROGRAM_CACHE_DIR ".shader_cache"
+
+// Cache files older than this are removed when the cache is written.
+#define PROGRAM_CACHE_MAX_FILES 64
+
+
+namespace ProgramCache
+{
+    // Returns linked program or 0 if the binary was not found or the driver rejected it.
+    uint32_t load(uint64_t hash);
+
+    // The program must be linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT.
+    void store(uint64_t hash, uint32_t program);
+};
+
+
+
+#endif
@@ -6,6 +6,7 @@
 #include <rcamera.h>
 
 #include <stdio.h>
+#include <algorithm>
 #include <GLFW/glfw3.h>
 
 #include "imgui.h"
@@ -14,6 +15,7 @@
 #include "preproc.hpp"
 #include "uniform_metadata.hpp"
 #include "logfile.hpp"
+#include "config.hpp"
 
 #include <rlgl.h>
 
@@ -40,11 +42,12 @@ GLSL_VERSION
 "out vec4 out_color;"
 "uniform sampler2D fuckshit;\n"
 "uniform vec2 ures;\n"
+"uniform vec2 uscale;\n" // Render size / texture size.
 "\n"
 "void main()\n"
 "{\n"
 "    vec2 uv = (gl_FragCoord.xy) / ures;"
-"    out_color = texture(fuckshit, uv);\n"
+"    out_color = texture(fuckshit, uv * uscale);\n"
 "}\n"
 ;
 
@@ -102,7 +105,7 @@ void RMSB::load_resources() {
 }
 
 void RMSB::init(const char* imgui_font_ttf, const char* editor_font_ttf) {
-    this->running = true;
+    this->set_default_values();
 
     SetTraceLogLevel(LOG_ALL);
     SetTraceLogCallback(raylib_message);
@@ -119,8 +122,11 @@ void RMSB::init(const char* imgui_font_ttf, const char* editor_font_ttf) {
 
     glEnable(GL_DEBUG_OUTPUT);
     glDebugMessageCallback(opengl_message, 0);
+    init_device_hash();
 
     this->load_resources();
+    this->gpu_timer.init();
+    this->render_params_ubo = create_ubo(RENDER_PARAMS_BINDING, sizeof(struct render_params_t));
 
     Editor& editor = Editor::get_instance();
     editor.init(editor_font_ttf);
@@ -128,6 +134,37 @@ void RMSB::init(const char* imgui_font_ttf, const char* editor_font_ttf) {
 
     this->gui.init(imgui_font_ttf);
 
+    if(this->file_watcher.init()) {
+        this->file_watcher.watch(INTERNAL_LIB_FILEPATH, WATCH_LIBRARY);
+        this->file_watcher.watch(CONFIG_FILE, WATCH_CONFIG);
+        this->watch_files();
+    }
+
+    SetTargetFPS(this->fps_limit);
+    
+    ToggleBorderlessWindowed();
+
+    int current_mon = GetCurrentMonitor();
+    this->monitor_width = GetMonitorWidth(current_mon);
+    this->monitor_height = GetMonitorHeight(current_mon);
+
+    // Output shader to show the results.
+    this->output_shader = load_shader_from_mem(OUT_VERTEX_SHADER_CODE, OUT_FRAGMENT_SHADER_CODE);
+    build_uniform_table(this->output_shader.id, &m_output_uniforms);
+    m_locs.ures = find_uniform_location(&m_output_uniforms, "ures");
+    m_locs.uscale = find_uniform_location(&m_output_uniforms, "uscale");
+    m_locs.output_sampler = find_uniform_location(&m_output_uniforms, "fuckshit");
+   
+    /*
+    // This is the texture everything is rendered on.
+    this->render_texture = create_empty_texture(
+            this->monitor_width,
+            this->monitor_height,
+            GL_RGBA16F);
+    */
+}
+
+void RMSB::set_default_values() {
     m_infolog_size = 0;
     m_first_shader_load = true;
     m_pos_uniform_ptr = NULL;
@@ -136,15 +173,33 @@ void RMSB::init(const char* imgui_font_ttf, const char* editor_font_ttf) {
         m_infolog[i].enabled = 0;
     }
 
+    this->running = true;
+    this->compute_shader = 0;
+    this->render_params_ubo = 0;
+    this->workgroup_size = DEFAULT_WORKGROUP_SIZE;
+    m_compute_hash = 0;
+    m_lib.shader = 0;
+    m_lib.hash = 0;
+    m_pending.lib_shader = 0;
+    m_pending.lib_hash = 0;
+    m_pending.program = (struct pending_program_t) { 0, 0, 0 };
+    m_pending.from_cache = false;
+    m_pending.from_variant = false;
+    m_locs = (struct builtin_locations_t) { -1, -1, -1, -1, -1, -1 };
+    this->render_texture.id = 0;
+    this->output_shader = (Shader){ 0, NULL };
+    this->res.num_images = 0;
+
     this->translucent_step_size = 0.1;
     this->ao_step_size = 0.01;
     this->ao_num_samples = 32;
     this->ao_falloff = 3.0;
     this->auto_reload = false;
-    this->auto_reload_delay = 3.0;
     this->input_key = 0;
     this->mode = EDIT_MODE;
     this->fps_limit = 300;
+    this->scene_fps = 0;
+    m_next_scene_frame = 0.0;
     this->show_infolog = true;
     this->reset_time_on_reload = true;
     this->time_paused = false;
@@ -152,9 +207,47 @@ void RMSB::init(const char* imgui_font_ttf, const char* editor_font_ttf) {
     this->time = 0.0;
     this->file_read_timer = 0.0f;
     this->show_fps = true;
+    this->show_gpu_timings = false;
+    this->render_width = 0;
+    this->render_height = 0;
+    this->dynamic_resolution = false;
+    this->dynamic_target_ms = 8.0f;
+    this->render_scale = 1.0f;
+    m_dynamic_res_sample = 0;
+    this->tiled_rendering = false;
+    this->tile_budget_ms = 8.0f;
+    this->display_texture.id = 0;
+    m_depth_texture.id = 0;
+    this->depth_prepass = false;
+    m_tiles.next_tile = 0;
+    m_tiles.num_x = 0;
+    m_tiles.num_y = 0;
+    m_tiles.program = 0;
+    m_tiles.tiles_per_frame = 1.0f;
+    m_tiles.timer_sample = 0;
+    for(int i = 0; i < OUTPUT_RING_SIZE; i++) {
+        m_ring.images[i] = (struct output_image_t) {
+            .texture = {}, .fence = NULL, .width = 0, .height = 0, .has_image = false
+        };
+    }
+    m_ring.newest = 0;
+    m_ring.shown = -1;
+    m_ring.needs_dispatch = true;
+    this->temporal_accumulation = true;
+    this->accum_max_frames = 64;
+    this->bake_uniforms = false;
+    for(int i = 0; i < FEATURE_COUNT; i++) {
+        this->features[i] = SHADER_FEATURES[i].default_enabled;
+    }
+    m_accum.num_frames = 0;
+    m_tiles.needs_update = true;
+    m_view.state.clear();
+    m_view.uses_time = true;
+    m_view.force_update = true;
     this->fov = 60.0;
     this->hit_distance = 0.001000;
     this->max_ray_len = 1000.0;
+    this->relaxation = 1.0;
     this->allow_camera_input = false; 
     this->ray_camera = (struct camera_t) {
         .pos = (Vector3){ 0, 0, 0 },
@@ -163,29 +256,6 @@ void RMSB::init(const char* imgui_font_ttf, const char* editor_font_ttf) {
         .sensetivity = 0.065,
         .move_speed = 6
     };
-
-
-
-
-
-    SetTargetFPS(this->fps_limit);
-    
-    ToggleBorderlessWindowed();
-
-    int current_mon = GetCurrentMonitor();
-    this->monitor_width = GetMonitorWidth(current_mon);
-    this->monitor_height = GetMonitorHeight(current_mon);
-
-    // Output shader to show the results.
-    this->output_shader = load_shader_from_mem(OUT_VERTEX_SHADER_CODE, OUT_FRAGMENT_SHADER_CODE);
-   
-    /*
-    // This is the texture everything is rendered on.
-    this->render_texture = create_empty_texture(
-            this->monitor_width,
-            this->monitor_height,
-            GL_RGBA16F);
-    */
 }
 
 Texture RMSB::create_empty_texture(int width, int height, int format) {
@@ -231,26 +301,58 @@ uint32_t RMSB::create_ssbo(int binding_point, size_t size) {
     return ssbo;
 }
 
+uint32_t RMSB::create_ubo(int binding_point, size_t size) {
+    uint32_t ubo = 0;
+
+    glGenBuffers(1, &ubo);
+    glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+    glBufferData(GL_UNIFORM_BUFFER, size, NULL, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, binding_point, ubo);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    return ubo;
+}
+
 void RMSB::quit() {
     printf("%s: %s\n", __FILE__, __func__);
 
+    this->unload_gl_resources();
+    this->file_watcher.quit();
+
+    this->gui.quit();
+    CloseWindow();
+
+}
+
+void RMSB::unload_gl_resources() {
+    this->gpu_timer.quit();
+
     if(this->output_shader.id > 0) {
         unload_shader(&this->output_shader);
     }
 
-    if(this->compute_shader > 0) {
-        glDeleteProgram(this->compute_shader);
+    this->cancel_pending_shader();
+    this->delete_variants();
+    this->compute_shader = 0;
+
+    if(m_lib.shader > 0) {
+        glDeleteShader(m_lib.shader);
+        m_lib.shader = 0;
+    }
+
+    if(this->render_params_ubo > 0) {
+        glDeleteBuffers(1, &this->render_params_ubo);
+        this->render_params_ubo = 0;
     }
 
     this->delete_texture(&this->render_texture);
+    this->delete_texture(&this->display_texture);
+    this->delete_texture(&m_depth_texture);
+    this->delete_output_ring();
 
     for(uint16_t i = 0; i < this->res.num_images; i++) {
         this->delete_texture(&this->res.images[i]);
     }
-
-    this->gui.quit();
-    CloseWindow();
-
 }
 
 void RMSB::update_camera() {
@@ -302,6 +404,9 @@ void RMSB::update_camera() {
 }
 
 void RMSB::update() {
+    this->update_watched_files();
+    this->update_shader_reload(false);
+
     if(!this->time_paused) {
         this->time += GetFrameTime() * this->time_mult;
     }
@@ -312,12 +417,419 @@ void RMSB::update() {
 }
 
 void RMSB::render_shader() {
+    this->gpu_timer.enabled = this->show_gpu_timings
+                           || this->dynamic_resolution
+                           || this->tiled_rendering
+                           || this->gpu_timer.is_csv_open();
+
+    Texture* output_tex = &this->render_texture;
+    int output_width = this->render_width;
+    int output_height = this->render_height;
 
-    const float ftime = (float)this->time;
+    if(this->dynamic_resolution && !this->tiled_rendering) {
+        this->update_dynamic_resolution();
+    }
+
+    // When nothing has changed the previous image is drawn again without running the shader.
+    const bool view_changed = this->update_view_state();
+
+    if(this->tiled_rendering) {
+        if(view_changed) {
+            m_accum.num_frames = 0;
+            m_tiles.needs_update = true;
+        }
+        if((m_tiles.needs_update || (m_tiles.next_tile > 0))
+        && this->is_scene_frame_due()) {
+            this->dispatch_tiles();
+        }
+        output_tex = &this->display_texture;
+        output_width = m_tiles.display_width;
+        output_height = m_tiles.display_height;
+    }
+    else {
+        if(view_changed) {
+            m_accum.num_frames = 0;
+            m_ring.needs_dispatch = true;
+        }
+        else
+        if(this->temporal_accumulation
+        && (m_accum.num_frames < this->accum_max_frames)) {
+            m_ring.needs_dispatch = true;
+        }
+
+        // If the GPU is still busy with the previous image it is not waited for,
+        // the dispatch happens on a later frame.
+        if(this->update_output_ring() && m_ring.needs_dispatch
+        && this->is_scene_frame_due()) {
+            this->dispatch_compute(m_accum.num_frames);
+            m_accum.num_frames++;
+            this->push_output_image();
+            m_ring.needs_dispatch = false;
+        }
+
+        if(m_ring.shown >= 0) {
+            struct output_image_t* image = &m_ring.images[m_ring.shown];
+            output_tex = &image->texture;
+            output_width = image->width;
+            output_height = image->height;
+        }
+    }
+
+    // Draw the results from the compute shader.
+    
     Vector2 monitor_size = (Vector2) {
         (float)this->monitor_width, (float)this->monitor_height
     };
 
+    Vector2 render_scale = (Vector2) {
+        (float)output_width / (float)output_tex->width,
+        (float)output_height / (float)output_tex->height
+    };
+
+    this->gpu_timer.begin(GPU_PHASE_OUTPUT);
+    BeginShaderMode(this->output_shader);
+    shader_uniform_vec2(this->output_shader.id, m_locs.ures, monitor_size);
+    shader_uniform_vec2(this->output_shader.id, m_locs.uscale, render_scale);
+    rlEnableShader(this->output_shader.id);
+    rlSetUniformSampler(m_locs.output_sampler, output_tex->id);
+   
+    DrawRectangle(0, 0, this->monitor_width, this->monitor_height, RED);
+    EndShaderMode();
+    this->gpu_timer.end(GPU_PHASE_OUTPUT);
+}
+
+void RMSB::dispatch_compute(int accum_frame) {
+    if(this->compute_shader == 0) {
+        return;
+    }
+
+    this->set_compute_uniforms(this->time, this->ray_camera, this->get_accum_params(accum_frame));
+    shader_uniform_ivec2(compute_shader, m_locs.tile_offset, 0, 0);
+    this->bind_output_image();
+
+    this->gpu_timer.begin(GPU_PHASE_COMPUTE);
+
+    // Accumulated frames have the same view.
+    this->dispatch_depth_prepass(accum_frame == 0);
+    // Round up, pixels outside of render size are discarded by the shader.
+    const struct workgroup_size_t wg = this->workgroup_size;
+    glDispatchCompute(
+            (this->render_width + wg.x - 1) / wg.x,
+            (this->render_height + wg.y - 1) / wg.y, 1);
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    this->gpu_timer.end(GPU_PHASE_COMPUTE);
+}
+
+bool RMSB::is_scene_frame_due() {
+    if(this->scene_fps <= 0) {
+        return true;
+    }
+
+    const double now = GetTime();
+    if(now < m_next_scene_frame) {
+        return false;
+    }
+
+    // Next time is counted from the previous one so the rate stays even with frame time jitter.
+    const double interval = 1.0 / (double)this->scene_fps;
+    m_next_scene_frame += interval;
+    if(m_next_scene_frame < now) {
+        m_next_scene_frame = now + interval; // Fell behind, dont try to catch up.
+    }
+    return true;
+}
+
+bool RMSB::update_output_ring() {
+    int num_in_flight = 0;
+    for(int i = 0; i < OUTPUT_RING_SIZE; i++) {
+        struct output_image_t* image = &m_ring.images[i];
+        if(!image->fence) {
+            continue;
+        }
+        const GLenum status = glClientWaitSync((GLsync)image->fence, 0, 0);
+        if((status == GL_ALREADY_SIGNALED) || (status == GL_CONDITION_SATISFIED)) {
+            glDeleteSync((GLsync)image->fence);
+            image->fence = NULL;
+        }
+        else {
+            num_in_flight++;
+        }
+    }
+
+    // Newest finished image is shown.
+    for(int i = 0; i < OUTPUT_RING_SIZE; i++) {
+        const int index = (m_ring.newest + OUTPUT_RING_SIZE - i) % OUTPUT_RING_SIZE;
+        const struct output_image_t* image = &m_ring.images[index];
+        if(image->has_image && !image->fence) {
+            m_ring.shown = index;
+            break;
+        }
+    }
+
+    // One image is always kept for showing, others can be rendered at the same time.
+    const int next = (m_ring.newest + 1) % OUTPUT_RING_SIZE;
+    return (num_in_flight < OUTPUT_RING_SIZE-1) && (next != m_ring.shown) && !m_ring.images[next].fence;
+}
+
+void RMSB::push_output_image() {
+    const int next = (m_ring.newest + 1) % OUTPUT_RING_SIZE;
+    struct output_image_t* image = &m_ring.images[next];
+
+    if((image->texture.id == 0)
+    || (image->texture.width != this->render_texture.width)
+    || (image->texture.height != this->render_texture.height)) {
+        this->delete_texture(&image->texture);
+        image->texture = create_empty_texture(
+                this->render_texture.width,
+                this->render_texture.height,
+                this->render_texture.format);
+    }
+
+    // 'render_texture' keeps the accumulated image for the next dispatch.
+    glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+    glCopyImageSubData(
+            this->render_texture.id, GL_TEXTURE_2D, 0, 0, 0, 0,
+            image->texture.id, GL_TEXTURE_2D, 0, 0, 0, 0,
+            this->render_width, this->render_height, 1);
+
+    image->fence = (void*)glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    image->width = this->render_width;
+    image->height = this->render_height;
+    image->has_image = true;
+    m_ring.newest = next;
+}
+
+void RMSB::delete_output_ring() {
+    for(int i = 0; i < OUTPUT_RING_SIZE; i++) {
+        struct output_image_t* image = &m_ring.images[i];
+        if(image->fence) {
+            glDeleteSync((GLsync)image->fence);
+            image->fence = NULL;
+        }
+        this->delete_texture(&image->texture);
+        image->has_image = false;
+    }
+    m_ring.shown = -1;
+    m_ring.needs_dispatch = true;
+}
+
+void RMSB::dispatch_depth_prepass(bool update) {
+    if(!this->depth_prepass || (m_locs.depth_pass < 0)) {
+        shader_uniform_int(compute_shader, m_locs.depth_pass, DEPTH_PASS_OFF);
+        return;
+    }
+
+    // Sized for the whole 'render_texture' so dynamic resolution doesnt need new texture.
+    const int width = (this->render_texture.width + DEPTH_PREPASS_TILE-1) / DEPTH_PREPASS_TILE;
+    const int height = (this->render_texture.height + DEPTH_PREPASS_TILE-1) / DEPTH_PREPASS_TILE;
+    if((m_depth_texture.id == 0)
+    || (m_depth_texture.width != width)
+    || (m_depth_texture.height != height)) {
+        this->delete_texture(&m_depth_texture);
+        m_depth_texture = create_empty_texture(width, height, GL_R32F);
+        update = true;
+    }
+
+    glBindImageTexture(DEPTH_PREPASS_BINDING, m_depth_texture.id, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32F);
+
+    if(update) {
+        const struct workgroup_size_t wg = this->workgroup_size;
+        const int num_x = (this->render_width + DEPTH_PREPASS_TILE-1) / DEPTH_PREPASS_TILE;
+        const int num_y = (this->render_height + DEPTH_PREPASS_TILE-1) / DEPTH_PREPASS_TILE;
+
+        shader_uniform_int(compute_shader, m_locs.depth_pass, DEPTH_PASS_WRITE);
+        glDispatchCompute((num_x + wg.x - 1) / wg.x, (num_y + wg.y - 1) / wg.y, 1);
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    }
+
+    shader_uniform_int(compute_shader, m_locs.depth_pass, DEPTH_PASS_READ);
+}
+
+void RMSB::dispatch_tiles() {
+    if(this->compute_shader == 0) {
+        return;
+    }
+
+    if((this->display_texture.id == 0)
+    || (this->display_texture.width != this->render_texture.width)
+    || (this->display_texture.height != this->render_texture.height)) {
+        this->delete_texture(&this->display_texture);
+        this->display_texture = create_empty_texture(
+                this->render_texture.width,
+                this->render_texture.height,
+                this->render_texture.format);
+        
+        // Show what was rendered before until the first tiled image is complete.
+        glCopyImageSubData(
+                this->render_texture.id, GL_TEXTURE_2D, 0, 0, 0, 0,
+                this->display_texture.id, GL_TEXTURE_2D, 0, 0, 0, 0,
+                this->render_texture.width, this->render_texture.height, 1);
+        m_tiles.display_width = this->render_width;
+        m_tiles.display_height = this->render_height;
+        m_tiles.next_tile = 0;
+    }
+
+    // Start over if the image cant be finished like it was started.
+    if((m_tiles.program != this->compute_shader)
+    || (m_tiles.width != this->render_width)
+    || (m_tiles.height != this->render_height)) {
+        m_tiles.next_tile = 0;
+    }
+
+    if(m_tiles.next_tile == 0) {
+        m_tiles.needs_update = false;
+        m_tiles.width = this->render_width;
+        m_tiles.height = this->render_height;
+        m_tiles.num_x = (this->render_width + RENDER_TILE_SIZE-1) / RENDER_TILE_SIZE;
+        m_tiles.num_y = (this->render_height + RENDER_TILE_SIZE-1) / RENDER_TILE_SIZE;
+        m_tiles.time = this->time;
+        m_tiles.camera = this->ray_camera;
+        m_tiles.program = this->compute_shader;
+    }
+
+    const int num_tiles = m_tiles.num_x * m_tiles.num_y;
+
+    // Adjust the tile count with the measured GPU time.
+    // The measurement is a few frames old, move only part of the way to avoid oscillating.
+    const uint64_t num_samples = this->gpu_timer.num_samples(GPU_PHASE_COMPUTE);
+    struct gpu_timer_stats_t stats;
+    if((num_samples != m_tiles.timer_sample)
+    && this->gpu_timer.get_stats(GPU_PHASE_COMPUTE, &stats)
+    && (stats.latest_ms > 0.0f)) {
+        float desired = m_tiles.tiles_per_frame * (this->tile_budget_ms / stats.latest_ms);
+        m_tiles.tiles_per_frame = Clamp(
+                Lerp(m_tiles.tiles_per_frame, desired, 0.3f), 1.0f, (float)num_tiles);
+    }
+    m_tiles.timer_sample = num_samples;
+
+    // Uniforms are set every frame because gui may change the texture bindings.
+    // Tiles are not accumulated.
+    this->set_compute_uniforms(m_tiles.time, m_tiles.camera, this->get_accum_params(0));
+    this->bind_output_image();
+
+    this->gpu_timer.begin(GPU_PHASE_COMPUTE);
+
+    // All tiles of the image have the same view.
+    this->dispatch_depth_prepass(m_tiles.next_tile == 0);
+
+    // Tiles next to each other on the same row are dispatched together.
+    int tiles_left = Clamp((int)m_tiles.tiles_per_frame, 1, num_tiles - m_tiles.next_tile);
+    while(tiles_left > 0) {
+        const int tile_x = m_tiles.next_tile % m_tiles.num_x;
+        const int tile_y = m_tiles.next_tile / m_tiles.num_x;
+        const int count = std::min(tiles_left, m_tiles.num_x - tile_x);
+
+        shader_uniform_ivec2(compute_shader, m_locs.tile_offset,
+                tile_x * RENDER_TILE_SIZE, tile_y * RENDER_TILE_SIZE);
+        glDispatchCompute(
+                count * (RENDER_TILE_SIZE / this->workgroup_size.x),
+                RENDER_TILE_SIZE / this->workgroup_size.y, 1);
+
+        m_tiles.next_tile += count;
+        tiles_left -= count;
+    }
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+    this->gpu_timer.end(GPU_PHASE_COMPUTE);
+
+    if(m_tiles.next_tile >= num_tiles) {
+        glCopyImageSubData(
+                this->render_texture.id, GL_TEXTURE_2D, 0, 0, 0, 0,
+                this->display_texture.id, GL_TEXTURE_2D, 0, 0, 0, 0,
+                m_tiles.width, m_tiles.height, 1);
+        m_tiles.display_width = m_tiles.width;
+        m_tiles.display_height = m_tiles.height;
+        m_tiles.next_tile = 0;
+    }
+}
+
+void RMSB::collect_view_state(std::vector<float>* state) {
+    state->clear();
+    state->push_back((float)this->compute_shader);
+    state->push_back(m_view.uses_time ? (float)this->time : 0.0f);
+    state->push_back((float)this->render_texture.id);
+    state->push_back((float)this->render_width);
+    state->push_back((float)this->render_height);
+    state->push_back((float)this->monitor_width);
+    state->push_back((float)this->monitor_height);
+    state->push_back((float)this->tiled_rendering);
+    state->push_back((float)this->temporal_accumulation);
+    state->push_back((float)this->depth_prepass);
+    state->push_back(this->ray_camera.pos.x);
+    state->push_back(this->ray_camera.pos.y);
+    state->push_back(this->ray_camera.pos.z);
+    state->push_back(this->ray_camera.yaw);
+    state->push_back(this->ray_camera.pitch);
+    state->push_back(this->fov);
+    state->push_back(this->hit_distance);
+    state->push_back(this->max_ray_len);
+    state->push_back(this->relaxation);
+    state->push_back(this->translucent_step_size);
+    state->push_back(this->ao_step_size);
+    state->push_back((float)this->ao_num_samples);
+    state->push_back(this->ao_falloff);
+
+    for(const Uniform& u : InternalLib::get_instance().uniforms) {
+        state->push_back((float)u.type);
+        state->insert(state->end(), u.values, u.values + 4);
+        state->push_back(u.has_texture ? (float)u.texture.id : 0.0f);
+    }
+}
+
+bool RMSB::update_view_state() {
+    // Both vectors keep their capacity so this doesnt allocate after the first frames.
+    this->collect_view_state(&m_view.next);
+
+    // Compared as bytes so NaN values are equal to themselves.
+    if(m_view.force_update
+    || (m_view.next.size() != m_view.state.size())
+    || (memcmp(m_view.next.data(), m_view.state.data(), m_view.next.size() * sizeof(float)) != 0)) {
+        m_view.state.swap(m_view.next);
+        m_view.force_update = false;
+        return true;
+    }
+    return false;
+}
+
+// Low discrepancy sequence for the subpixel jitter.
+static float halton(int index, int base) {
+    float f = 1.0f;
+    float result = 0.0f;
+    while(index > 0) {
+        f /= (float)base;
+        result += f * (float)(index % base);
+        index /= base;
+    }
+    return result;
+}
+
+void RMSB::bind_output_image() {
+	glBindImageTexture(
+            8, // Binding point.
+            this->render_texture.id,
+            0,
+            GL_FALSE,
+            0,
+            GL_READ_WRITE, // Read is needed for temporal accumulation.
+            this->render_texture.format
+            );
+}
+
+struct accum_params_t RMSB::get_accum_params(int accum_frame) {
+    // First frame of accumulation overwrites the image without jitter.
+    const int n = accum_frame;
+    Vector2 jitter = (Vector2) { 0.0f, 0.0f };
+    if(n > 0) {
+        jitter = (Vector2) { halton(n, 2) - 0.5f, halton(n, 3) - 0.5f };
+    }
+
+    return (struct accum_params_t) {
+        .pixel_jitter = jitter,
+        .noise_seed = (float)n * 0.6180339f,
+        .blend = 1.0f / (float)(n + 1)
+    };
+}
+
+void RMSB::set_compute_uniforms(double time, const struct camera_t& camera, const struct accum_params_t& accum) {
 
     int num_tex = 0;
     
@@ -330,17 +842,17 @@ void RMSB::render_shader() {
 
         switch(u.type) {
             case UniformDataType::RGBA:
-                shader_uniform_vec4(compute_shader, u.name.c_str(),
+                shader_uniform_vec4(compute_shader, u.location,
                         (Vector4){ u.values[0], u.values[1], u.values[2], u.values[3] });
                 break;
 
             case UniformDataType::XYZ:
-                shader_uniform_vec3(compute_shader, u.name.c_str(),
+                shader_uniform_vec3(compute_shader, u.location,
                         (Vector3){ -u.values[0], u.values[1], u.values[2] });
                 break;
 
             case UniformDataType::SINGLE:
-                shader_uniform_float(compute_shader, u.name.c_str(), u.values[0]);
+                shader_uniform_float(compute_shader, u.location, u.values[0]);
                 break;
 
             case UniformDataType::TEXTURE:
@@ -361,64 +873,123 @@ void RMSB::render_shader() {
     }
 
     if(num_tex > 0) {
-        glUniform1iv(
-                glGetUniformLocation(compute_shader, "TEXTURES"),
-                num_tex,
-                texN
-                );
-    }
-
-    shader_uniform_float(compute_shader, "time", ftime);
-    shader_uniform_float(compute_shader, "FOV", this->fov);
-    shader_uniform_float(compute_shader, "HIT_DISTANCE", this->hit_distance);
-    shader_uniform_float(compute_shader, "MAX_RAY_LENGTH", this->max_ray_len);
-    shader_uniform_vec2(compute_shader, "monitor_size", monitor_size);
-    shader_uniform_vec3(compute_shader, "CameraInputPosition", this->ray_camera.pos);
-    shader_uniform_float(compute_shader, "CAMERA_INPUT_YAW", this->ray_camera.yaw);
-    shader_uniform_float(compute_shader, "CAMERA_INPUT_PITCH", this->ray_camera.pitch);
-    shader_uniform_float(compute_shader, "TRANSLUCENT_STEP_SIZE", this->translucent_step_size);
-    shader_uniform_float(compute_shader, "AO_STEP_SIZE", this->ao_step_size);
-    shader_uniform_int(compute_shader, "AO_NUM_SAMPLES", this->ao_num_samples);
-    shader_uniform_float(compute_shader, "AO_FALLOFF", this->ao_falloff);
+        glProgramUniform1iv(compute_shader, m_locs.textures, num_tex, texN);
+    }
 
+    shader_uniform_float(compute_shader, m_locs.time, (float)time);
+
+    struct render_params_t params = (struct render_params_t) {
+        .monitor_size = (Vector2){ (float)this->monitor_width, (float)this->monitor_height },
+        .render_size = (Vector2){ (float)this->render_width, (float)this->render_height },
+        .pixel_jitter = accum.pixel_jitter,
+        .noise_seed = accum.noise_seed,
+        .accum_blend = accum.blend,
+        .camera_pos = camera.pos,
+        .fov = this->fov,
+        .hit_distance = this->hit_distance,
+        .max_ray_length = this->max_ray_len,
+        .translucent_step_size = this->translucent_step_size,
+        .camera_yaw = camera.yaw,
+        .camera_pitch = camera.pitch,
+        .ao_step_size = this->ao_step_size,
+        .ao_num_samples = this->ao_num_samples,
+        .ao_falloff = this->ao_falloff,
+        .relaxation = this->relaxation,
+        .padding = { 0 }
+    };
 
-	glBindImageTexture(
-            8, // Binding point.
-            this->render_texture.id,
-            0,
-            GL_FALSE,
-            0,
-            GL_WRITE_ONLY,
-            this->render_texture.format
-            );
+    glBindBufferBase(GL_UNIFORM_BUFFER, RENDER_PARAMS_BINDING, this->render_params_ubo);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(params), &params);
+}
 
-    glDispatchCompute(this->render_texture.width / 8, this->render_texture.height / 8, 1);
-    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
-   
+void RMSB::update_dynamic_resolution() {
+    const uint64_t num_samples = this->gpu_timer.num_samples(GPU_PHASE_COMPUTE);
+    if(num_samples == m_dynamic_res_sample) {
+        return; // No new measurement.
+    }
+    m_dynamic_res_sample = num_samples;
 
-    // Draw the results from the compute shader.
+    struct gpu_timer_stats_t stats;
+    if(!this->gpu_timer.get_stats(GPU_PHASE_COMPUTE, &stats) || (stats.latest_ms <= 0.0f)) {
+        return;
+    }
 
-    BeginShaderMode(this->output_shader);
-    shader_uniform_vec2(this->output_shader.id, "ures", monitor_size);
-    rlEnableShader(this->output_shader.id);
-    rlSetUniformSampler(GetShaderLocation(this->output_shader, "fuckshit"), this->render_texture.id);
-   
-    DrawRectangle(0, 0, this->monitor_width, this->monitor_height, RED);
-    EndShaderMode();
+    // GPU time is roughly proportional to pixel count, so area scales with the ratio.
+    // The measurement is a few frames old, move only part of the way to avoid oscillating.
+    float desired_scale = this->render_scale * sqrtf(this->dynamic_target_ms / stats.latest_ms);
+    desired_scale = Clamp(desired_scale, DYNAMIC_RES_MIN_SCALE, 1.0f);
+
+    float new_scale = Lerp(this->render_scale, desired_scale, 0.2f);
+    if(fabsf(new_scale - this->render_scale) < 0.01f) {
+        return;
+    }
+
+    this->render_scale = new_scale;
+    this->render_width = Clamp(this->render_texture.width * new_scale, 8, this->render_texture.width);
+    this->render_height = Clamp(this->render_texture.height * new_scale, 8, this->render_texture.height);
 }
 
-void RMSB::reload_shader() {
+void RMSB::set_dynamic_resolution(bool enabled) {
+    this->dynamic_resolution = enabled;
+    
+    if(enabled
+    && ((this->render_texture.width < this->monitor_width)
+    ||  (this->render_texture.height < this->monitor_height))) {
+        // Render texture must have space for full resolution.
+        this->delete_texture(&this->render_texture);
+        this->render_texture = create_empty_texture(
+                this->monitor_width,
+                this->monitor_height,
+                GL_RGBA16F);
+        this->render_scale = 0.5f;
+    }
+
+    if(!enabled) {
+        this->render_scale = 1.0f;
+    }
+
+    this->render_width = this->render_texture.width * this->render_scale;
+    this->render_height = this->render_texture.height * this->render_scale;
+    m_dynamic_res_sample = this->gpu_timer.num_samples(GPU_PHASE_COMPUTE);
+}
+
+void RMSB::update_compute_uniform_locations() {
+    build_uniform_table(this->compute_shader, &m_compute_uniforms);
+
+    m_locs.tile_offset = find_uniform_location(&m_compute_uniforms, "TILE_OFFSET");
+    m_locs.depth_pass = find_uniform_location(&m_compute_uniforms, "DEPTH_PASS");
+    m_locs.time = find_uniform_location(&m_compute_uniforms, "time");
+    m_locs.textures = find_uniform_location(&m_compute_uniforms, "TEXTURES");
+
+    // Linker removes the uniform if nothing uses it.
+    m_view.uses_time = (m_locs.time >= 0);
 
-    // Reset shader uniform locations.
     // New ones may be added or they maybe have changed.
-    shader_util_reset_locations();
-    
+    for(Uniform& u : InternalLib::get_instance().uniforms) {
+        u.location = find_uniform_location(&m_compute_uniforms, u.name.c_str());
+    }
+}
+
+void RMSB::reload_shader() {
+    this->reload_shader_from(Editor::get_instance().get_content());
+}
+
+static int count_lines(const struct shader_source_t& source) {
+    int num_lines = 0;
+    for(size_t i = 0; i < source.strings.size(); i++) {
+        num_lines += std::count(source.strings[i], source.strings[i] + source.lengths[i], '\n');
+    }
+    return num_lines;
+}
+
+void RMSB::reload_shader_from(std::string shader_code, bool copy_map) {
+
     ErrorLog& error_log = ErrorLog::get_instance();
-    Editor& editor = Editor::get_instance();
     
-    std::string shader_code = editor.get_content();
     error_log.clear();
    
+    copy_map = copy_map && this->features[FEATURE_DISTANCE_MAP];
+    std::string retry_code = copy_map ? shader_code : "";
 
     if(m_first_shader_load) {
         UniformMetadata::read(shader_code);
@@ -428,53 +999,408 @@ void RMSB::reload_shader() {
     // to be called everytime the shader gets reloaded
     UniformMetadata::remove(&shader_code);
 
+    // Included files are expanded first so the library sees what they use.
+    std::string include_defines = "";
+    std::vector<std::string> included;
+    Preproc::process_glsl(&shader_code, &include_defines, this->shader_filepath, &included);
+
+    this->file_watcher.unwatch_all(WATCH_INCLUDE);
+    for(const std::string& path : included) {
+        this->file_watcher.watch(path, WATCH_INCLUDE);
+    }
+
+    // After the includes so map() can be in an included file.
+    bool copied_map = false;
+    if(copy_map) {
+        shader_code += Preproc::get_distance_map(shader_code, &copied_map);
+    }
+    else
+    if(this->features[FEATURE_DISTANCE_MAP]) {
+        shader_code += Preproc::get_distance_map_fallback();
+    }
 
-    // Merge user shader code and internal lib.
-    std::string code = "";
-    code += GLSL_VERSION;
-    Preproc::process_glsl(&shader_code, &code);
+    InternalLib& ilib = InternalLib::get_instance();
 
-    code += InternalLib::get_instance().get_source();
-    code += shader_code;
-    code.push_back('\0');
+    // User shader is compiled with the internal lib declarations
+    // and linked with the already compiled internal lib.
+    // Library functions which the user shader doesnt use are left out.
+    struct library_code_t lib;
+    ilib.get_code(shader_code, &lib);
+
+    // Previous reload is not needed anymore if it didnt finish yet.
+    this->cancel_pending_shader();
+
+    // Code is not joined to one string, the parts are moved to where they are kept.
+    struct compute_code_t& code = m_pending.code;
+    code.defines = this->get_variant_defines() + include_defines;
+
+    m_pending.first_load = m_first_shader_load;
+    m_pending.copied_map = copied_map;
+    m_pending.retry_code = copied_map ? std::move(retry_code) : "";
+    m_pending.num_stripped_lines = lib.num_stripped_declarations;
+
+    code.declarations = std::move(lib.declarations);
+    code.uniforms = ilib.get_uniform_declarations(this->bake_uniforms);
+    code.user_code = std::move(shader_code);
+    m_pending.lib_defines = this->get_variant_defines();
+    m_pending.lib_code = std::move(lib.library);
+
+    struct shader_source_t lib_source;
+    this->add_library_source(m_pending.lib_defines, m_pending.lib_code, &lib_source);
+    m_pending.lib_hash = hash_shader_source(lib_source);
+
+    // Workgroup size is not part of this hash.
+    struct shader_source_t hash_source = lib_source;
+    this->add_compute_code(code, &hash_source);
+    m_pending.hash = hash_shader_source(hash_source);
+
+    // Use the best known workgroup size for this shader.
+    if(!Workgroup::find_cached(m_pending.hash, &m_pending.workgroup_size)) {
+        m_pending.workgroup_size = DEFAULT_WORKGROUP_SIZE;
+    }
 
+    // The old shader is used until the new one is ready. See 'update_shader_reload'
+    const std::string workgroup_defines = Workgroup::get_defines(m_pending.workgroup_size);
+    struct shader_source_t source;
+    source.add(GLSL_VERSION);
+    source.add(workgroup_defines);
+    this->add_compute_code(code, &source);
+
+    // Program binary includes the library too.
+    struct shader_source_t binary_source = source;
+    binary_source.add(lib_source);
+    m_pending.binary_hash = hash_shader_source(binary_source);
+
+    // Variants in memory are used first, then the program binaries on disk.
+    m_pending.program.program = this->find_variant(m_pending.binary_hash);
+    m_pending.from_variant = (m_pending.program.program > 0);
+    if(!m_pending.from_variant) {
+        m_pending.program.program = ProgramCache::load(m_pending.binary_hash);
+    }
+    m_pending.from_cache = (m_pending.program.program > 0);
+    m_pending.num_compiled_lines = 0;
+    m_pending.compile_ms = 0.0;
 
-    if(this->compute_shader > 0) {
-        glDeleteProgram(this->compute_shader);
+    if(!m_pending.from_cache) {
+        m_pending.num_compiled_lines = count_lines(source);
+
+        if((m_lib.shader > 0) && (m_lib.hash == m_pending.lib_hash)) {
+            m_pending.lib_shader = m_lib.shader;
+        }
+        else {
+            m_pending.lib_shader = compile_compute_shader_object(lib_source);
+            m_pending.num_compiled_lines += count_lines(lib_source);
+            m_pending.num_stripped_lines += lib.num_stripped_lines;
+        }
+
+        m_pending.begin_time = std::chrono::steady_clock::now();
+        begin_compute_shader(source, m_pending.lib_shader, &m_pending.program);
+        m_pending.compile_ms = std::chrono::duration<double, std::milli>
+            (std::chrono::steady_clock::now() - m_pending.begin_time).count();
+    }
+
+    m_first_shader_load = false;
+}
+
+void RMSB::update_shader_reload(bool wait) {
+    if(m_pending.program.program == 0) {
+        return;
+    }
+    if(!wait && !is_compute_shader_ready(&m_pending.program)) {
+        return;
     }
 
-    this->compute_shader = load_compute_shader(code.c_str());
+    const auto finish_begin = std::chrono::steady_clock::now();
+    uint32_t program = finish_compute_shader(&m_pending.program);
 
+    if(!m_pending.from_cache) {
+        if(!wait && has_parallel_shader_compile()) {
+            // Driver compiled it on its own threads, it finished before this poll.
+            m_pending.compile_ms = std::chrono::duration<double, std::milli>
+                (finish_begin - m_pending.begin_time).count();
+        }
+        else {
+            // Compile is done in the OpenGL calls, the rest of it happens here.
+            m_pending.compile_ms += std::chrono::duration<double, std::milli>
+                (std::chrono::steady_clock::now() - finish_begin).count();
+        }
+    }
 
     // Tell user what happened.
-    if(this->compute_shader > 0) {
-        loginfo(GREEN, !m_first_shader_load ? "Shader Reloaded." : "Shader Loaded.");
+    if(program > 0) {
+        if(!m_pending.from_cache) {
+            ProgramCache::store(m_pending.binary_hash, program);
+        }
+
+        this->keep_variant(m_pending.binary_hash, program);
+        m_pending.from_variant = false;
+
+        this->compute_shader = program;
+        this->workgroup_size = m_pending.workgroup_size;
+        std::swap(m_compute_code, m_pending.code);
+        m_compute_hash = m_pending.hash;
+        this->update_compute_uniform_locations();
+
+        // Library shader is kept for compiling the same shader again. See 'autotune_workgroup_size'
+        if(m_pending.lib_hash != m_lib.hash) {
+            if(m_lib.shader > 0) {
+                glDeleteShader(m_lib.shader);
+            }
+            m_lib.shader = m_pending.lib_shader; // Compiled later if loaded from cache.
+            m_lib.hash = m_pending.lib_hash;
+            m_lib.defines.swap(m_pending.lib_defines);
+            m_lib.code.swap(m_pending.lib_code);
+        }
+        m_pending.lib_shader = 0;
+
+        loginfo(GREEN, !m_pending.first_load ? "Shader Reloaded." : "Shader Loaded.");
+
+        // Nothing was compiled if the program came from the binary cache.
+        if(!m_pending.from_cache
+        && (m_pending.num_stripped_lines > 0) && (m_pending.num_compiled_lines > 0)) {
+            // Estimated from the compile time per line, it is not known exactly
+            // without compiling the full library too.
+            const double compile_ms = m_pending.compile_ms;
+            const double saved_ms = compile_ms
+                * ((double)m_pending.num_stripped_lines / (double)m_pending.num_compiled_lines);
+
+            loginfo(PURPLE, "Stripped %i lines, %0.0f ms (~%0.0f ms saved)",
+                    m_pending.num_stripped_lines, compile_ms, saved_ms);
+        }
+    
+        if(this->reset_time_on_reload) {
+            this->time = 0;
+        }
+    }
+    else
+    if(m_pending.copied_map) {
+        // Copy of map() may use something which DistMaterial doesnt have.
+        append_logfile(WARNING, "map_dist() failed to compile, compiling again with map() instead.");
+
+        const bool first_load = m_pending.first_load;
+        this->reload_shader_from(std::move(m_pending.retry_code), false);
+        m_pending.first_load = first_load;
+        this->update_shader_reload(wait);
+        return;
     }
     else {
+        // Previous shader keeps running.
         loginfo(RED, "Shader failed to compile.");
-        /*
-        fprintf(stderr,
-                "-----------------------\n"
-                "[ERROR]: \"%s\" Failed to compile...\n"
-                "======================================================\n"
-                "%s\n"
-                "=================================================[End]\n"
-                ,
-                shader_filepath.c_str(),
-                code.c_str()
-                );*/
-
-        error_log.get_error_position(&editor.error_row, &editor.error_column);
+        
+        Editor& editor = Editor::get_instance();
+        ErrorLog::get_instance().get_error_position(&editor.error_row, &editor.error_column);
+
+        this->release_pending_lib();
     }
-    
-    if(this->reset_time_on_reload) {
-        this->time = 0;
+
+    m_pending.code = compute_code_t();
+    m_pending.retry_code.clear();
+    m_pending.lib_defines.clear();
+    m_pending.lib_code.clear();
+}
+
+void RMSB::cancel_pending_shader() {
+    if(m_pending.from_variant) {
+        m_pending.program = (struct pending_program_t) { 0, 0, 0 };
+        m_pending.from_variant = false;
     }
-    
-    m_first_shader_load = false;
+    else {
+        cancel_compute_shader(&m_pending.program);
+    }
+    this->release_pending_lib();
+}
+
+uint32_t RMSB::find_variant(uint64_t binary_hash) {
+    for(const struct shader_variant_t& variant : m_variants) {
+        if(variant.binary_hash == binary_hash) {
+            return variant.program;
+        }
+    }
+    return 0;
+}
+
+void RMSB::keep_variant(uint64_t binary_hash, uint32_t program) {
+    for(size_t i = 0; i < m_variants.size(); i++) {
+        if(m_variants[i].binary_hash == binary_hash) {
+            if(m_variants[i].program != program) {
+                glDeleteProgram(m_variants[i].program);
+            }
+            m_variants.erase(m_variants.begin() + i);
+            break;
+        }
+    }
+
+    m_variants.insert(m_variants.begin(), (struct shader_variant_t) { binary_hash, program });
+
+    // Least recently used are removed. 'compute_shader' is always the first one.
+    while(m_variants.size() > RMSB_MAX_SHADER_VARIANTS) {
+        glDeleteProgram(m_variants.back().program);
+        m_variants.pop_back();
+    }
+}
+
+void RMSB::delete_variants() {
+    for(const struct shader_variant_t& variant : m_variants) {
+        glDeleteProgram(variant.program);
+    }
+    m_variants.clear();
+}
+
+void RMSB::release_pending_lib() {
+    if((m_pending.lib_shader > 0) && (m_pending.lib_shader != m_lib.shader)) {
+        glDeleteShader(m_pending.lib_shader);
+    }
+    m_pending.lib_shader = 0;
 }
         
 
+void RMSB::add_compute_code(const struct compute_code_t& code, struct shader_source_t* source) {
+    source->add(code.defines);
+    source->add(SHADER_LINE_LIBRARY);
+    source->add(code.declarations);
+    source->add(code.uniforms);
+    source->add(SHADER_LINE_USER);
+    source->add(code.user_code);
+}
+
+uint32_t RMSB::compile_compute_shader(struct workgroup_size_t size, uint64_t* binary_hash) {
+    const std::string workgroup_defines = Workgroup::get_defines(size);
+
+    struct shader_source_t source;
+    source.add(GLSL_VERSION);
+    source.add(workgroup_defines);
+    this->add_compute_code(m_compute_code, &source);
+
+    // Same as in 'reload_shader_from'
+    struct shader_source_t binary_source = source;
+    this->add_library_source(m_lib.defines, m_lib.code, &binary_source);
+    *binary_hash = hash_shader_source(binary_source);
+
+    return load_compute_shader(source, this->get_lib_shader());
+}
+
+void RMSB::add_library_source(const std::string& defines, const std::string& code, struct shader_source_t* source) {
+    source->add(GLSL_VERSION);
+    source->add(defines);
+    source->add(SHADER_LINE_LIBRARY);
+    source->add(code);
+}
+
+uint32_t RMSB::get_lib_shader() {
+    if(m_lib.shader == 0) {
+        struct shader_source_t source;
+        this->add_library_source(m_lib.defines, m_lib.code, &source);
+        m_lib.shader = compile_compute_shader_object(source);
+    }
+    return m_lib.shader;
+}
+
+std::string RMSB::get_variant_defines() {
+    return Preproc::get_feature_defines(this->features) + this->get_baked_defines();
+}
+
+std::string RMSB::get_baked_defines() {
+    if(!this->bake_uniforms) {
+        return "";
+    }
+
+    // Names must match the ones in 'internal.glsl' RenderParams.
+    std::string code = "#define RENDER_PARAMS_BAKED\n";
+    code += "#define FOV "                   + glsl_float(this->fov) + "\n";
+    code += "#define HIT_DISTANCE "          + glsl_float(this->hit_distance) + "\n";
+    code += "#define MAX_RAY_LENGTH "        + glsl_float(this->max_ray_len) + "\n";
+    code += "#define TRANSLUCENT_STEP_SIZE " + glsl_float(this->translucent_step_size) + "\n";
+    code += "#define AO_STEP_SIZE "          + glsl_float(this->ao_step_size) + "\n";
+    code += "#define AO_NUM_SAMPLES "        + std::to_string(this->ao_num_samples) + "\n";
+    code += "#define AO_FALLOFF "            + glsl_float(this->ao_falloff) + "\n";
+    code += "#define RELAXATION "            + glsl_float(this->relaxation) + "\n";
+    return code;
+}
+
+void RMSB::autotune_workgroup_size() {
+    if(this->compute_shader == 0) {
+        loginfo(RED, "No shader to tune.");
+        return;
+    }
+
+    constexpr int num_warmup = 1;
+    constexpr int num_samples = 3;
+
+    uint32_t queries[2] = { 0, 0 }; // Begin and end timestamp.
+    glGenQueries(2, queries);
+
+    const uint32_t original_program = this->compute_shader;
+    const struct workgroup_size_t original_size = this->workgroup_size;
+
+    uint32_t best_program = 0;
+    uint64_t best_binary_hash = 0;
+    struct workgroup_size_t best_size = original_size;
+    double best_ms = 0.0;
+
+    for(const struct workgroup_size_t& size : WORKGROUP_CANDIDATES) {
+        uint64_t binary_hash = 0;
+        uint32_t program = compile_compute_shader(size, &binary_hash);
+        if(program == 0) {
+            continue;
+        }
+
+        this->compute_shader = program;
+        this->workgroup_size = size;
+        this->update_compute_uniform_locations();
+
+        double min_ms = -1.0;
+        for(int i = 0; i < num_warmup + num_samples; i++) {
+            glQueryCounter(queries[0], GL_TIMESTAMP);
+            this->dispatch_compute();
+            glQueryCounter(queries[1], GL_TIMESTAMP);
+
+            GLuint64 begin_ns = 0;
+            GLuint64 end_ns = 0;
+            glGetQueryObjectui64v(queries[0], GL_QUERY_RESULT, &begin_ns);
+            glGetQueryObjectui64v(queries[1], GL_QUERY_RESULT, &end_ns);
+            
+            const double ms = (double)(end_ns - begin_ns) / 1000000.0;
+            if((i >= num_warmup) && ((min_ms < 0.0) || (ms < min_ms))) {
+                min_ms = ms;
+            }
+        }
+
+        append_logfile(INFO, "Workgroup size %ix%i: %0.3f ms", size.x, size.y, min_ms);
+
+        if((best_program == 0) || (min_ms < best_ms)) {
+            if(best_program > 0) {
+                glDeleteProgram(best_program);
+            }
+            best_program = program;
+            best_binary_hash = binary_hash;
+            best_size = size;
+            best_ms = min_ms;
+        }
+        else {
+            glDeleteProgram(program);
+        }
+    }
+
+    glDeleteQueries(2, queries);
+
+    if(best_program == 0) {
+        this->compute_shader = original_program;
+        this->workgroup_size = original_size;
+        this->update_compute_uniform_locations();
+        loginfo(RED, "Workgroup size tuning failed.");
+        return;
+    }
+
+    // Original program stays in 'm_variants'
+    this->keep_variant(best_binary_hash, best_program);
+    this->compute_shader = best_program;
+    this->workgroup_size = best_size;
+    this->update_compute_uniform_locations();
+
+    Workgroup::store_cached(m_compute_hash, best_size);
+    loginfo(GREEN, "Workgroup size %ix%i (%0.2f ms)", best_size.x, best_size.y, best_ms);
+}
+
 void RMSB::reload_lib() {
     InternalLib& ilib = InternalLib::get_instance();
     ilib.clear();
@@ -484,7 +1410,60 @@ void RMSB::reload_lib() {
     loginfo(PURPLE, "Internal library reloaded");
 }
 
+void RMSB::watch_files() {
+    this->file_watcher.unwatch_all(WATCH_SHADER);
+    this->file_watcher.watch(this->shader_filepath, WATCH_SHADER);
+}
+
+void RMSB::update_watched_files() {
+    // Events are read even if not used so they dont pile up.
+    const uint32_t changed = this->file_watcher.poll();
+    if((changed == 0) || !this->auto_reload) {
+        return;
+    }
+
+    bool reload = false;
+
+    if(changed & WATCH_BIT(WATCH_CONFIG)) {
+        reload |= Config::reload_render_settings(this);
+    }
+
+    if(changed & WATCH_BIT(WATCH_INCLUDE)) {
+        reload = true;
+    }
+
+    if(changed & WATCH_BIT(WATCH_SHADER)) {
+        Editor& editor = Editor::get_instance();
+        char* data = LoadFileText(this->shader_filepath.c_str());
+        if(data) {
+            const std::string content = data;
+            UnloadFileText(data);
+
+            if(editor.is_saved_content(content)) {
+                reload = true; // Saved from the editor.
+            }
+            else
+            if(editor.content_changed) {
+                loginfo(RED, "Shader changed on disk, editor is unsaved.");
+            }
+            else {
+                editor.load_data(content);
+                reload = true;
+            }
+        }
+    }
+
+    if(changed & WATCH_BIT(WATCH_LIBRARY)) {
+        this->reload_lib(); // Reloads the shader too.
+    }
+    else
+    if(reload) {
+        this->reload_shader();
+    }
+}
+
 void RMSB::reload_state() {
+    this->watch_files();
     this->reload_lib();
     Editor::get_instance().clear_undo_stack();
     m_first_shader_load = true;
@@ -2,6 +2,8 @@
 #define RAYMARCH_SANDBOX_HPP
 
 #include <string>
+#include <vector>
+#include <chrono>
 #include <raylib.h>
 
 #include "rmsb_gui.hpp"
@@ -9,6 +11,12 @@
 #include "error_log.hpp"
 #include "editor.hpp"
 #include "filebrowser.hpp"
+#include "gpu_timer.hpp"
+#include "file_watcher.hpp"
+#include "shader_util.hpp"
+#include "workgroup.hpp"
+#include "program_cache.hpp"
+#include "preproc.hpp"
 
 
 #define GLSL_VERSION "#version 430\n"
@@ -18,6 +26,27 @@
 
 #define INFO_ARRAY_MAX_SIZE 32
 
+// Dynamic resolution will not go below this scale of the monitor size.
+#define DYNAMIC_RES_MIN_SCALE 0.25f
+
+// Size of the tiles in pixels when tiled rendering is enabled.
+// Must be multiple of all WORKGROUP_CANDIDATES sizes.
+#define RENDER_TILE_SIZE 64
+
+// Depth pre-pass, these must match the ones in 'internal.glsl'
+#define DEPTH_PREPASS_TILE    8
+#define DEPTH_PREPASS_BINDING 9
+
+enum DepthPass : int {
+    DEPTH_PASS_OFF = 0,
+    DEPTH_PASS_WRITE,
+    DEPTH_PASS_READ
+};
+
+// Finished images are copied to a ring of output images which are drawn to the screen.
+// Next image is dispatched while the previous finished one is shown.
+#define OUTPUT_RING_SIZE 2
+
 
 // Info text is used to give user any feedback of ..really anything happening.
 // from saving a file to glsl errors. It has a setting to be disabled.
@@ -28,6 +57,14 @@ struct infotext_t {
     int   enabled;
 };
 
+// Temporal accumulation values for one dispatch.
+// See 'RMSB::get_accum_params'
+struct accum_params_t {
+    Vector2 pixel_jitter;
+    float   noise_seed;
+    float   blend; // 1.0 overwrites the image.
+};
+
 // Raymarch camera.
 struct camera_t {
     Vector3 pos;
@@ -55,6 +92,35 @@ enum ImageIdx : uint16_t {
 
 #define RMSB_MAX_RESOURCE_IMAGES 8
 
+// How many compiled compute shader variants are kept in memory.
+#define RMSB_MAX_SHADER_VARIANTS 8
+
+// Uniform buffer binding point for 'RenderParams' in 'internal.glsl'
+#define RENDER_PARAMS_BINDING 0
+
+// Matches 'RenderParams' uniform block in 'internal.glsl' (std140 layout).
+struct render_params_t {
+    Vector2 monitor_size;
+    Vector2 render_size;
+    Vector2 pixel_jitter;
+    float   noise_seed;
+    float   accum_blend;
+    Vector3 camera_pos;
+    float   fov;
+    float   hit_distance;
+    float   max_ray_length;
+    float   translucent_step_size;
+    float   camera_yaw;
+    float   camera_pitch;
+    float   ao_step_size;
+    int     ao_num_samples;
+    float   ao_falloff;
+    float   relaxation;
+    float   padding[3];
+};
+
+static_assert(sizeof(struct render_params_t) == 96, "render_params_t must match std140 layout.");
+
 
 class RMSB {
     public:
@@ -62,6 +128,7 @@ class RMSB {
         
         Shader           output_shader;  // This shader is for drawing the texture compute shader created.
         uint32_t         compute_shader; // This shader is the user's controlled shader.
+        uint32_t         render_params_ubo;
         Texture render_texture; // aka Output texture (TODO: Rename this?).
 
         struct resource_t {
@@ -76,14 +143,15 @@ class RMSB {
 
         double time;
         float time_mult;
-        float auto_reload_delay;
-        bool auto_reload;
+        bool auto_reload; // Reload when the shader, 'internal.glsl' or 'rmsb.ini' is changed on disk.
         bool time_paused;
         bool reset_time_on_reload;
         bool show_infolog;
         bool allow_camera_input;
         int fps_limit;
+        int scene_fps; // How often the compute shader is dispatched, 0 is every frame.
         bool show_fps;
+        bool show_gpu_timings;
 
         float file_read_timer;
     
@@ -91,6 +159,7 @@ class RMSB {
         float hit_distance;
         float max_ray_len;
         float translucent_step_size;
+        float relaxation; // Over-relaxed sphere tracing step multiplier, 1.0 is plain sphere tracing.
         
         // Ambient occlusion settings.
         int   ao_num_samples;
@@ -100,7 +169,67 @@ class RMSB {
         int monitor_width;
         int monitor_height;
 
+        // The compute shader renders to this area of 'render_texture'
+        // starting from bottom left corner.
+        int render_width;
+        int render_height;
+
+        // When enabled 'render_texture' is monitor size
+        // and render size is scaled to keep the compute shader GPU time near 'dynamic_target_ms'.
+        bool  dynamic_resolution;
+        float dynamic_target_ms;
+        float render_scale;
+        
+        void  set_dynamic_resolution(bool enabled);
+
+        // Tiled rendering splits the image to tiles and dispatches only as many
+        // as fits in 'tile_budget_ms' of GPU time per frame.
+        // The last complete image is copied to 'display_texture' and shown until the next one is finished.
+        // This keeps the gui responsive even if the shader is very slow.
+        // NOTE: Dynamic resolution is not updated while tiled rendering is enabled.
+        bool    tiled_rendering;
+        float   tile_budget_ms;
+        Texture display_texture;
+
+        int  get_tiles_done() { return m_tiles.next_tile; }
+        int  get_num_tiles()  { return m_tiles.num_x * m_tiles.num_y; }
+
+        // When nothing changes, new frames are blended into 'render_texture'.
+        // Pixel position is jittered and noise seed changes every frame,
+        // the image converges to anti-aliased and noise free result.
+        // After 'accum_max_frames' the compute shader is not dispatched until something changes.
+        // NOTE: Not used while tiled rendering is enabled.
+        bool temporal_accumulation;
+        int  accum_max_frames;
+
+        int  get_accum_frames() { return m_accum.num_frames; }
+
+        // Before the full resolution dispatch, one ray for each DEPTH_PREPASS_TILE sized tile
+        // is cone marched to find how far all rays of the tile can start.
+        // Most useful in open scenes where rays cross a lot of empty space near the camera.
+        // NOTE: Assumes the primary rays are from 'Raydir()' and start from the same position.
+        bool depth_prepass;
+
+        // Render settings (fov, hit distance, ray length, translucent step and ao settings)
+        // and custom uniforms are compiled to the shader as constants.
+        // The compiler can then unroll loops and fold the math using them.
+        // Changes to the values are used after the shader is reloaded.
+        bool bake_uniforms;
+
+        // Optional code paths of the internal library. See 'src/preproc.hpp'
+        // Programs for recently used combinations are kept, switching back to them is instant.
+        bool features[FEATURE_COUNT];
+
+        // Compute shader local size. See 'src/workgroup.hpp'
+        struct workgroup_size_t workgroup_size;
+
+        // Compiles the current shader with all WORKGROUP_CANDIDATES
+        // and keeps the fastest one. The result is cached for the shader and device.
+        void autotune_workgroup_size();
+
         RMSBGui      gui;
+        GpuTimer     gpu_timer;
+        FileWatcher  file_watcher;
 
         struct camera_t ray_camera;
         Camera          raster_camera;
@@ -110,18 +239,42 @@ class RMSB {
         void quit();
         void update();
 
+        // Sets all settings and state to their defaults.
+        // Called from init() but can be used without a window. (See 'src/headless.cpp')
+        void set_default_values();
+
+        // Deletes the shaders and textures, the window is left open.
+        void unload_gl_resources();
+
         // TODO: Add support for reading values back.
         // this is here because of it. (Not implemented yet).
         uint32_t         create_ssbo(int binding_point, size_t size);
+        uint32_t         create_ubo(int binding_point, size_t size);
      
         Texture create_empty_texture(int width, int height, int format);
         void    delete_texture(Texture* tex);
 
         void render_3d();
-        void render_shader();
+        void render_shader();    // Dispatch compute shader and draw the results.
+        // Only update 'render_texture'. 'accum_frame' is the temporal accumulation frame,
+        // 0 overwrites the image without jitter.
+        void dispatch_compute(int accum_frame = 0);
         
-        void reload_shader();
+        // The shader is compiled in the background, 'update_shader_reload' swaps it in when ready.
+        void reload_shader(); // Reads the code from editor.
+        // If 'copy_map' is false, map_dist() calls map() instead of being a copy of it.
+        void reload_shader_from(std::string shader_code, bool copy_map = true);
+
+        // Called every frame from 'update'.
+        // If 'wait' is true, blocks until the reloaded shader is ready.
+        void update_shader_reload(bool wait);
         void reload_lib();
+
+        // Watches the files used by the current shader.
+        void watch_files();
+
+        // Called every frame from 'update'. Reloads what was changed if 'auto_reload' is enabled.
+        void update_watched_files();
         
         // Reload shader,
         // Reload internal lib,
@@ -159,6 +312,168 @@ class RMSB {
 
         void edit_position_uniform();
         void update_camera();
+        void update_dynamic_resolution();
+
+        uint64_t m_dynamic_res_sample; // Last GpuTimer sample used for dynamic resolution.
+
+        // Returns true if it is time to render the scene again. See 'scene_fps'
+        bool is_scene_frame_due();
+        double m_next_scene_frame;
+
+        struct accumulation_t {
+            int num_frames;
+        } m_accum;
+
+        // The compute shader is dispatched only if the view state changes.
+        struct view_state_t {
+            std::vector<float> state; // Everything that affects the image. See 'collect_view_state'
+            std::vector<float> next;  // Collected every frame, kept to reuse the memory.
+            bool     uses_time;       // Time doesnt change the image if the shader doesnt use it.
+            bool     force_update;    // First frame.
+        } m_view;
+
+        void collect_view_state(std::vector<float>* state);
+        bool update_view_state(); // Returns true if the view changed since last call.
+
+        struct uniform_table_t m_compute_uniforms;
+        struct uniform_table_t m_output_uniforms;
+
+        // Locations of the uniforms set every frame.
+        struct builtin_locations_t {
+            int tile_offset;
+            int depth_pass;
+            int time;
+            int textures;
+            int ures;
+            int uscale;
+            int output_sampler;
+        } m_locs;
+
+        // Called after the compute shader is loaded.
+        void update_compute_uniform_locations();
+
+        // Compute shader code after #version and the workgroup size defines.
+        // The parts are given to OpenGL as they are, see 'add_compute_code'
+        // Internal library is not included, it is linked from 'm_lib'
+        struct compute_code_t {
+            std::string defines;      // From 'Preproc'
+            std::string declarations; // Internal library declarations.
+            std::string uniforms;     // Custom uniforms.
+            std::string user_code;
+        };
+
+        void add_compute_code(const struct compute_code_t& code, struct shader_source_t* source);
+
+        struct compute_code_t m_compute_code;
+        uint64_t              m_compute_hash;
+
+        // Internal library used by the compute shader, compiled as its own shader object.
+        // It is compiled again only when the library code changes
+        // or the user code starts to use functions which were left out.
+        struct library_shader_t {
+            uint32_t    shader; // Compiled when needed.
+            uint64_t    hash;
+            std::string defines; // Features and baked render settings.
+            std::string code;
+        } m_lib;
+
+        // Defines for the baked render settings or empty if 'bake_uniforms' is not enabled.
+        std::string get_baked_defines();
+
+        // Defines which are used for both the library and the user code.
+        std::string get_variant_defines();
+        void add_library_source(const std::string& defines, const std::string& code, struct shader_source_t* source);
+
+        uint32_t get_lib_shader();
+
+        // Compiles the current shader code with different workgroup size.
+        uint32_t compile_compute_shader(struct workgroup_size_t size, uint64_t* binary_hash);
+
+        // Recently used compute programs, most recently used first. 'compute_shader' is one of them.
+        struct shader_variant_t {
+            uint64_t binary_hash;
+            uint32_t program;
+        };
+        std::vector<struct shader_variant_t> m_variants;
+
+        uint32_t find_variant(uint64_t binary_hash);
+        void     keep_variant(uint64_t binary_hash, uint32_t program);
+        void     delete_variants();
+
+        // Shader which is being compiled.
+        struct pending_shader_t {
+            struct pending_program_t program;
+            struct compute_code_t code;
+            uint64_t    hash;
+            uint64_t    binary_hash; // For ProgramCache, includes the workgroup size.
+            bool        from_cache;
+            bool        from_variant; // Program is owned by 'm_variants'
+            bool        first_load;
+            bool        copied_map;  // map_dist() is a copy of map()
+            std::string retry_code;  // Compiled again without the copy if it fails.
+            struct workgroup_size_t workgroup_size;
+
+            std::string lib_defines;
+            std::string lib_code;
+            uint64_t    lib_hash;
+            uint32_t    lib_shader; // May be shared with 'm_lib'
+            int         num_stripped_lines; // Only counted from the code which is compiled.
+            int         num_compiled_lines;
+            std::chrono::steady_clock::time_point begin_time; // When the compile was started.
+            double      compile_ms; // Time spent in the compile calls, without the waits between frames.
+        } m_pending;
+
+        // Deletes the pending library shader if the compute shader doesnt use it.
+        void release_pending_lib();
+        void cancel_pending_shader();
+
+        struct accum_params_t get_accum_params(int accum_frame);
+        void set_compute_uniforms(double time, const struct camera_t& camera, const struct accum_params_t& accum);
+        void bind_output_image();
+        void dispatch_tiles();
+
+        // Must be called after the compute uniforms are set.
+        // If 'update' is false the depth from previous pre-pass is used.
+        void dispatch_depth_prepass(bool update);
+        Texture m_depth_texture;
+
+        struct tiled_render_t {
+            int      next_tile;
+            int      num_x;
+            int      num_y;
+            int      width;   // Render size when the image was started.
+            int      height;
+            double   time;    // Time and camera are the same for all tiles of the image.
+            struct camera_t camera;
+            uint32_t program;
+            float    tiles_per_frame;
+            uint64_t timer_sample;
+            bool     needs_update; // View changed after the current image was started.
+
+            // Render size of the image in 'display_texture'
+            int      display_width;
+            int      display_height;
+        } m_tiles;
+
+        struct output_image_t {
+            Texture  texture;
+            void*    fence;  // GLsync, NULL when the image is finished.
+            int      width;  // Render size of the image.
+            int      height;
+            bool     has_image;
+        };
+
+        struct output_ring_t {
+            struct output_image_t images[OUTPUT_RING_SIZE];
+            int      newest; // Index of the latest dispatched image.
+            int      shown;  // Index of the latest finished image or -1
+            bool     needs_dispatch; // View changed or accumulation is not complete.
+        } m_ring;
+
+        // Checks which images have finished, returns true if the next one can be dispatched.
+        bool update_output_ring();
+        void push_output_image();
+        void delete_output_ring();
 };
 
 
@@ -231,7 +231,9 @@ void RMSBGui::render(RMSB* rmsb) {
     
 
     ImGui::Render();
+    rmsb->gpu_timer.begin(GPU_PHASE_IMGUI);
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    rmsb->gpu_timer.end(GPU_PHASE_IMGUI);
 }
         
 
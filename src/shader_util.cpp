@@ -1,5 +1,3 @@
-#include <map>
-#include <string_view>
 #include <stdio.h>
 #include <cstring>
 
@@ -200,25 +198,150 @@ error:
     return shader;
 }
 
-uint32_t load_compute_shader(const char* code) {
-    uint32_t program = glCreateProgram();
+uint32_t load_compute_shader(const struct shader_source_t& source, uint32_t lib_shader) {
+    struct pending_program_t pending;
+    begin_compute_shader(source, lib_shader, &pending);
+    return finish_compute_shader(&pending);
+}
 
 
-    uint32_t shader = compile_shader(code, GL_COMPUTE_SHADER);
-    if(shader == 0) {
-        glDeleteProgram(program);
-        program = 0;
-        goto error;
+// GL_KHR_parallel_shader_compile (Not in 'libs/glad.h')
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+
+bool has_parallel_shader_compile() {
+    static int supported = -1;
+    if(supported < 0) {
+        supported = 0;
+        int num_extensions = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &num_extensions);
+        for(int i = 0; i < num_extensions; i++) {
+            const char* ext = (const char*)glGetStringi(GL_EXTENSIONS, i);
+            if(ext && (strcmp(ext, "GL_KHR_parallel_shader_compile") == 0)) {
+                supported = 1;
+                break;
+            }
+        }
     }
+    return (supported == 1);
+}
 
-    glAttachShader(program, shader);
-    glLinkProgram(program);
+static void add_info_log_to_errors(uint32_t object, bool is_program) {
+    int log_max_len = 0;
+    if(is_program) {
+        glGetProgramiv(object, GL_INFO_LOG_LENGTH, &log_max_len);
+    }
+    else {
+        glGetShaderiv(object, GL_INFO_LOG_LENGTH, &log_max_len);
+    }
 
-    glDetachShader(program, shader);
-    glDeleteShader(shader);
+    if(log_max_len <= 0) {
+        return;
+    }
 
+    std::string log(log_max_len, '\0');
+    int log_len = 0;
+    if(is_program) {
+        glGetProgramInfoLog(object, log_max_len, &log_len, log.data());
+    }
+    else {
+        glGetShaderInfoLog(object, log_max_len, &log_len, log.data());
+    }
 
-error:
+    ErrorLog::get_instance().add(log.c_str());
+}
+
+uint32_t compile_compute_shader_object(const struct shader_source_t& source) {
+    uint32_t shader = glCreateShader(GL_COMPUTE_SHADER);
+    glShaderSource(shader, source.strings.size(), source.strings.data(), source.lengths.data());
+    glCompileShader(shader);
+    return shader;
+}
+
+void begin_compute_shader(const struct shader_source_t& source, uint32_t lib_shader, struct pending_program_t* pending) {
+    pending->shader = compile_compute_shader_object(source);
+    pending->lib_shader = lib_shader;
+
+    // Link is issued right away, it fails if the compile failed.
+    pending->program = glCreateProgram();
+    glProgramParameteri(pending->program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glAttachShader(pending->program, pending->shader);
+    if(lib_shader > 0) {
+        glAttachShader(pending->program, lib_shader);
+    }
+    glLinkProgram(pending->program);
+}
+
+bool is_compute_shader_ready(const struct pending_program_t* pending) {
+    if(pending->program == 0) {
+        return false;
+    }
+    if((pending->shader == 0) || !has_parallel_shader_compile()) {
+        return true;
+    }
+
+    int completed = 0;
+    glGetProgramiv(pending->program, GL_COMPLETION_STATUS_KHR, &completed);
+    return completed;
+}
+
+void cancel_compute_shader(struct pending_program_t* pending) {
+    if(pending->program > 0) {
+        glDeleteProgram(pending->program);
+    }
+    if(pending->shader > 0) {
+        glDeleteShader(pending->shader);
+    }
+    pending->program = 0;
+    pending->shader = 0;
+    pending->lib_shader = 0;
+}
+
+uint32_t finish_compute_shader(struct pending_program_t* pending) {
+    uint32_t program = pending->program;
+    if(pending->shader == 0) {
+        pending->program = 0;
+        pending->lib_shader = 0;
+        return program; // Already linked from binary.
+    }
+
+    int compile_ok = 0;
+    glGetShaderiv(pending->shader, GL_COMPILE_STATUS, &compile_ok);
+
+    int lib_compile_ok = 1;
+    if(pending->lib_shader > 0) {
+        glGetShaderiv(pending->lib_shader, GL_COMPILE_STATUS, &lib_compile_ok);
+    }
+    
+    int link_ok = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &link_ok);
+
+    if(!lib_compile_ok) {
+        add_info_log_to_errors(pending->lib_shader, false);
+        compile_ok = 0;
+    }
+    else
+    if(!compile_ok) {
+        add_info_log_to_errors(pending->shader, false);
+    }
+    else
+    if(!link_ok) {
+        add_info_log_to_errors(program, true);
+    }
+
+    glDetachShader(program, pending->shader);
+    glDeleteShader(pending->shader);
+    if(pending->lib_shader > 0) {
+        glDetachShader(program, pending->lib_shader);
+    }
+
+    if(!compile_ok || !link_ok) {
+        glDeleteProgram(program);
+        program = 0;
+    }
+
+    pending->program = 0;
+    pending->shader = 0;
+    pending->lib_shader = 0;
     return program;
 }
 
@@ -271,51 +394,129 @@ not_valid:
 }
 
 
-static std::map<std::string_view, int> g_locations;
+// FNV-1a
+static uint64_t hash_bytes(uint64_t hash, const char* data, size_t size) {
+    for(size_t i = 0; i < size; i++) {
+        hash ^= (uint8_t)data[i];
+        hash *= 0x100000001B3;
+    }
+    return hash;
+}
 
+static uint64_t g_device_hash = 0xCBF29CE484222325; // See 'init_device_hash'
 
-static int get_ulocation(uint32_t shader, const char* name) {
-    auto e = g_locations.find(name);
-    int loc = 0;
-    if(e != g_locations.end()) {
-        loc = g_locations[name];
+void init_device_hash() {
+    uint64_t hash = 0xCBF29CE484222325;
+    
+    const GLenum device_info[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+    for(GLenum name : device_info) {
+        const char* str = (const char*)glGetString(name);
+        if(str) {
+            hash = hash_bytes(hash, str, strlen(str));
+        }
     }
-    else {
-        loc = glGetUniformLocation(shader, name);
-        if(loc >= 0) {
-            g_locations[name] = loc;
+    g_device_hash = hash;
+}
+
+std::string glsl_float(float value) {
+    char buf[32] = { 0 };
+    snprintf(buf, sizeof(buf), "%.9g", value);
+
+    std::string str = buf;
+    if(str.find_first_of(".en") == std::string::npos) {
+        str += ".0";
+    }
+    return str;
+}
+
+uint64_t hash_shader_source(const std::string& code) {
+    return hash_bytes(g_device_hash, code.data(), code.size());
+}
+
+uint64_t hash_shader_source(const struct shader_source_t& source) {
+    // Same as hashing the joined string.
+    uint64_t hash = g_device_hash;
+    for(size_t i = 0; i < source.strings.size(); i++) {
+        hash = hash_bytes(hash, source.strings[i], source.lengths[i]);
+    }
+    return hash;
+}
+
+
+void build_uniform_table(uint32_t program, struct uniform_table_t* table) {
+    table->program = program;
+    table->uniforms.clear();
+    if(program == 0) {
+        return;
+    }
+
+    int num_uniforms = 0;
+    glGetProgramInterfaceiv(program, GL_UNIFORM, GL_ACTIVE_RESOURCES, &num_uniforms);
+
+    int max_name_len = 0;
+    glGetProgramInterfaceiv(program, GL_UNIFORM, GL_MAX_NAME_LENGTH, &max_name_len);
+
+    std::string name_buf(max_name_len + 1, '\0');
+    const GLenum props[] = { GL_LOCATION, GL_TYPE, GL_ARRAY_SIZE };
+
+    table->uniforms.reserve(num_uniforms);
+    for(int i = 0; i < num_uniforms; i++) {
+        GLint values[3] = { -1, 0, 0 };
+        glGetProgramResourceiv(program, GL_UNIFORM, i, 3, props, 3, NULL, values);
+
+        GLsizei name_len = 0;
+        glGetProgramResourceName(program, GL_UNIFORM, i, name_buf.size(), &name_len, name_buf.data());
+
+        std::string name(name_buf.data(), name_len);
+        if((name.size() > 3) && (name.compare(name.size()-3, 3, "[0]") == 0)) {
+            name.erase(name.size()-3);
+        }
+
+        table->uniforms.push_back((struct uniform_info_t) {
+            .name = name,
+            .location = values[0],
+            .type = (uint32_t)values[1],
+            .array_size = values[2]
+        });
+    }
+}
+
+int find_uniform_slot(const struct uniform_table_t* table, const char* name) {
+    for(size_t i = 0; i < table->uniforms.size(); i++) {
+        if(table->uniforms[i].name == name) {
+            return (int)i;
         }
     }
-    return loc;
+    return -1;
+}
+
+int find_uniform_location(const struct uniform_table_t* table, const char* name) {
+    const int slot = find_uniform_slot(table, name);
+    return (slot >= 0) ? table->uniforms[slot].location : -1;
 }
 
-void shader_util_reset_locations() {
-    g_locations.clear();
+void shader_uniform_int   (uint32_t shader, int location, const int&   value) {
+    glProgramUniform1i(shader, location, value);
 }
 
-void shader_uniform_int   (uint32_t shader, const char* name, const int&   value) {
-    glUseProgram(shader);
-    glUniform1i(get_ulocation(shader, name), value);
+void shader_uniform_float (uint32_t shader, int location, const float& value) {
+    glProgramUniform1f(shader, location, value);
 }
 
-void shader_uniform_float (uint32_t shader, const char* name, const float& value) {
-    glUseProgram(shader);
-    glUniform1f(get_ulocation(shader, name), value);
+void shader_uniform_vec2  (uint32_t shader, int location, const Vector2& value) {
+    glProgramUniform2f(shader, location, value.x, value.y);
 }
 
-void shader_uniform_vec2  (uint32_t shader, const char* name, const Vector2& value) {
-    glUseProgram(shader);
-    glUniform2f(get_ulocation(shader, name), value.x, value.y);
+void shader_uniform_vec3  (uint32_t shader, int location, const Vector3& value) {
+    glProgramUniform3f(shader, location, value.x, value.y, value.z);
 }
 
-void shader_uniform_vec3  (uint32_t shader, const char* name, const Vector3& value) {
-    glUseProgram(shader);
-    glUniform3f(get_ulocation(shader, name), value.x, value.y, value.z);
+void shader_uniform_vec4  (uint32_t shader, int location, const Vector4& value) {
+    glProgramUniform4f(shader, location, value.x, value.y, value.z, value.w);
 }
 
-void shader_uniform_vec4  (uint32_t shader, const char* name, const Vector4& value) {
-    glUseProgram(shader);
-    glUniform4f(get_ulocation(shader, name), value.x, value.y, value.z, value.w);
+void shader_uniform_ivec2 (uint32_t shader, int location, int x, int y) {
+    glProgramUniform2i(shader, location, x, y);
 }
 
 
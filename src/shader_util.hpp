@@ -2,8 +2,11 @@
 #define SHADER_UTIL_HPP
 
 #include <cstddef>
+#include <cstring>
 #include <raylib.h>
 #include <cstdint>
+#include <string>
+#include <vector>
 
 
 /*
@@ -19,18 +22,108 @@ enum ShaderUniformI {
 */
 
 
+// '#line' directives set the source string number for the code after them.
+// Errors are reported as "<source>:<row>(<column>)" See 'ErrorLog::get_error_position'
+#define SHADER_SOURCE_USER    0
+#define SHADER_LINE_USER      "#line 0 0\n"
+#define SHADER_LINE_LIBRARY   "#line 1 1\n"
+#define SHADER_SOURCE_DISTANCE_MAP 2 // Copy of map(), see 'Preproc::get_distance_map'
+#define SHADER_SOURCE_INCLUDE 3 // First one for included files. See 'src/preproc.cpp'
+
+
+// Shader source is given to glShaderSource in parts without joining them to one string.
+// The strings must stay valid and unchanged until the shader is compiled.
+struct shader_source_t {
+    std::vector<const char*> strings;
+    std::vector<int>         lengths;
+
+    void add(const char* str, size_t size) {
+        strings.push_back(str);
+        lengths.push_back((int)size);
+    }
+    void add(const std::string& str) { add(str.data(), str.size()); }
+    void add(const char* str) { add(str, strlen(str)); }
+    void add(const shader_source_t& source) {
+        strings.insert(strings.end(), source.strings.begin(), source.strings.end());
+        lengths.insert(lengths.end(), source.lengths.begin(), source.lengths.end());
+    }
+};
+
+
 Shader load_shader_from_mem(const char* vs_code, const char* fs_code);
-uint32_t load_compute_shader(const char* code);
+uint32_t load_compute_shader(const struct shader_source_t& source, uint32_t lib_shader = 0); // Blocks until the program is linked.
+
+// Compiles a shader object which can be linked with multiple compute programs.
+// Compile status is checked when a program using it is finished.
+uint32_t compile_compute_shader_object(const struct shader_source_t& source);
+
+
+// Compute shader can be compiled and linked without waiting for the result.
+// If GL_KHR_parallel_shader_compile is supported the driver compiles it on its own threads
+// and 'is_compute_shader_ready' can be polled without blocking.
+// Without the extension the compile happens on the next OpenGL call which needs the result.
+struct pending_program_t {
+    uint32_t program; // 0 if nothing is pending.
+    uint32_t shader;  // 0 if the program was loaded from binary.
+    uint32_t lib_shader; // Linked with 'shader' if not 0. Not owned by the program.
+};
+
+void     begin_compute_shader(const struct shader_source_t& source, uint32_t lib_shader, struct pending_program_t* pending);
+bool     is_compute_shader_ready(const struct pending_program_t* pending);
+bool     has_parallel_shader_compile();
+void     cancel_compute_shader(struct pending_program_t* pending);
+
+// Blocks if not ready. Returns the program or 0 if it failed, errors are added to ErrorLog.
+uint32_t finish_compute_shader(struct pending_program_t* pending);
 void   unload_shader(Shader* shader);
 
 bool is_uniform_name_valid(const char* name, size_t name_size);
 
-void shader_util_reset_locations();
-void shader_uniform_int   (uint32_t shader, const char* name, const int&   value);
-void shader_uniform_float (uint32_t shader, const char* name, const float& value);
-void shader_uniform_vec2  (uint32_t shader, const char* name, const Vector2& value);
-void shader_uniform_vec3  (uint32_t shader, const char* name, const Vector3& value);
-void shader_uniform_vec4  (uint32_t shader, const char* name, const Vector4& value);
+// Float constant which GLSL reads back to the same value. For example "1.0" not "1"
+std::string glsl_float(float value);
+
+// Hashes the OpenGL device (vendor, renderer, version) for 'hash_shader_source'
+// Called once after the OpenGL context is created.
+void init_device_hash();
+
+// Hash of the shader code and the OpenGL device (vendor, renderer, version).
+// Same code gives the same hash between runs.
+uint64_t hash_shader_source(const std::string& code);
+uint64_t hash_shader_source(const struct shader_source_t& source);
+
+
+// Active uniforms of a linked program.
+// The table is built once after linking, uniforms are updated with the locations from it
+// so there are no name lookups every frame.
+// Uniforms which the compiler removed (not used by the shader) are not in the table.
+struct uniform_info_t {
+    std::string name;     // Arrays have the "[0]" removed.
+    int         location; // -1 for uniform block members.
+    uint32_t    type;     // GL_FLOAT, GL_FLOAT_VEC3, ...
+    int         array_size;
+};
+
+struct uniform_table_t {
+    uint32_t program;
+    std::vector<struct uniform_info_t> uniforms; // Index is the slot.
+};
+
+void build_uniform_table(uint32_t program, struct uniform_table_t* table);
+
+// Returns slot index to 'table->uniforms' or -1 if the uniform is not active.
+int  find_uniform_slot(const struct uniform_table_t* table, const char* name);
+
+// Returns -1 if the uniform is not active. Setting value for location -1 is ignored by OpenGL.
+int  find_uniform_location(const struct uniform_table_t* table, const char* name);
+
+
+// These dont change the current program.
+void shader_uniform_int   (uint32_t shader, int location, const int&   value);
+void shader_uniform_float (uint32_t shader, int location, const float& value);
+void shader_uniform_vec2  (uint32_t shader, int location, const Vector2& value);
+void shader_uniform_vec3  (uint32_t shader, int location, const Vector3& value);
+void shader_uniform_vec4  (uint32_t shader, int location, const Vector4& value);
+void shader_uniform_ivec2 (uint32_t shader, int location, int x, int y);
 
 
 
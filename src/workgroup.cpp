@@ -0,0 +1,84 @@
+#include <stdio.h>
+#include <cinttypes>
+#include <map>
+
+#include "workgroup.hpp"
+#include "logfile.hpp"
+
+
+// Loaded from WORKGROUP_CACHE_FILE on first use.
+static std::map<uint64_t, struct workgroup_size_t> g_cache;
+static bool g_cache_loaded = false;
+
+
+static bool is_candidate(struct workgroup_size_t size) {
+    for(const struct workgroup_size_t& c : WORKGROUP_CANDIDATES) {
+        if((c.x == size.x) && (c.y == size.y)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void load_cache() {
+    g_cache_loaded = true;
+
+    FILE* fp = fopen(WORKGROUP_CACHE_FILE, "r");
+    if(!fp) {
+        return; // Nothing has been cached yet.
+    }
+
+    uint64_t hash = 0;
+    struct workgroup_size_t size;
+    while(fscanf(fp, "%" SCNx64 " %dx%d", &hash, &size.x, &size.y) == 3) {
+        // The file may be edited by hand, tiles and dispatch sizes work only with the candidates.
+        if(!is_candidate(size)) {
+            append_logfile(WARNING, "Ignored workgroup size %ix%i from \"%s\"",
+                    size.x, size.y, WORKGROUP_CACHE_FILE);
+            continue;
+        }
+        g_cache[hash] = size;
+    }
+
+    fclose(fp);
+}
+
+
+std::string Workgroup::get_defines(struct workgroup_size_t size) {
+    return "#define WORKGROUP_SIZE_X " + std::to_string(size.x) + "\n"
+           "#define WORKGROUP_SIZE_Y " + std::to_string(size.y) + "\n";
+}
+
+bool Workgroup::find_cached(uint64_t hash, struct workgroup_size_t* size) {
+    if(!g_cache_loaded) {
+        load_cache();
+    }
+
+    auto e = g_cache.find(hash);
+    if(e == g_cache.end()) {
+        return false;
+    }
+
+    *size = e->second;
+    return true;
+}
+
+void Workgroup::store_cached(uint64_t hash, struct workgroup_size_t size) {
+    if(!g_cache_loaded) {
+        load_cache();
+    }
+
+    g_cache[hash] = size;
+
+    FILE* fp = fopen(WORKGROUP_CACHE_FILE, "w");
+    if(!fp) {
+        append_logfile(ERROR, "Failed to open \"%s\" for writing.", WORKGROUP_CACHE_FILE);
+        return;
+    }
+
+    for(const auto& e : g_cache) {
+        fprintf(fp, "%016" PRIx64 " %ix%i\n", e.first, e.second.x, e.second.y);
+    }
+
+    fclose(fp);
+}
@@ -0,0 +1,41 @@
+#ifndef WORKGROUP_HPP
+#define WORKGROUP_HPP
+
+#include <cstdint>
+#include <string>
+
+
+// The compute shader workgroup size is set with defines when it is compiled.
+// Best size depends on the driver and the shader, RMSB::autotune_workgroup_size
+// times the candidates and the winner is saved to a file for the shader and device.
+
+#define WORKGROUP_CACHE_FILE "workgroup_cache.txt"
+
+struct workgroup_size_t {
+    int x;
+    int y;
+};
+
+static const struct workgroup_size_t WORKGROUP_CANDIDATES[] = {
+    { 8,  8 },
+    { 16, 8 },
+    { 16, 16 },
+    { 32, 4 },
+    { 64, 1 }
+};
+
+static const struct workgroup_size_t DEFAULT_WORKGROUP_SIZE = { 8, 8 };
+
+
+namespace Workgroup
+{
+    // Defines for 'internal.glsl' layout. Must be added after #version.
+    std::string get_defines(struct workgroup_size_t size);
+
+    bool find_cached(uint64_t hash, struct workgroup_size_t* size);
+    void store_cached(uint64_t hash, struct workgroup_size_t size);
+};
+
+
+
+#endif